@@ -7,28 +7,7 @@
 #include <vector>
 
 #include <sqnmanip/sqn/fzy.hpp>
-
-/**
- * readFasta
- *
- * @brief
- * Read complete file contents into a string.
- * @param fileName Name of the file in current working directory.
- * @return The file contents as single string.
- */
-std::string readFasta (const char* fileName) {
-    std::ifstream file(fileName);
-    std::stringstream buffer;
-    std::string::size_type index = 0;
-    for(std::string line; getline(file, line);) {
-        /* TODO: Fix Fasta EOF bug -> Genbank format */
-        index = line.find('\n', index);
-        if (index != std::string::npos)
-            line.erase(index);
-        buffer << line;
-    }
-    return buffer.str();
-}
+#include <sqnmanip/sqn/io.hpp>
 
 /**
  * itemParse
@@ -64,8 +43,11 @@ std::string helper_center(std::string str, int width) {
 }
 
 int main() {
-    std::string sequence = readFasta("data/AAV-CamKII-GCaMP6s-WPRE-SV40.fasta");
-    sqn::Sequence<Dna5> genome(sequence), t7tag = "atggctagcatgactggtggacagcaaatgggt";
+    sqn::SequenceReader reader("data/AAV-CamKII-GCaMP6s-WPRE-SV40.fasta");
+    sqn::Record record;
+    sqn::Sequence<Dna5> genome, t7tag = "atggctagcatgactggtggacagcaaatgggt";
+    if (reader.next(record))
+        record.read(genome);
     
     sqn::FuzzyQuery<Dna5Sequence> analysis = {genome, t7tag};
     
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sqnmanip/sqn/fzy.hpp>
+
+/**
+ * readBases
+ *
+ * @brief
+ * Read the bases of a fasta file, header lines are skipped.
+ * @param fileName Name of the file in current working directory.
+ * @return The bases as single string.
+ */
+std::string readBases (const char* fileName) {
+    std::ifstream file(fileName);
+    std::string bases;
+    for(std::string line; getline(file, line);) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty() && line[0] != '>')
+            bases += line;
+    }
+    return bases;
+}
+
+/**
+ * run
+ *
+ * @brief
+ * Search the needle in the haystack with one engine and report giga cell updates per second.
+ * @param engine The engine used by the query.
+ * @param fills How often the query computes every cell, once per match for the matrix engines.
+ * @param matches The formatted matches found by the query.
+ * @return The giga cell updates per second.
+ */
+double run (sqn::Engine engine, Dna5Sequence& haystack, Dna5Sequence& needle,
+            int amount, int fills, int repeats, std::vector<std::string>& matches) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        sqn::FuzzyQuery<Dna5Sequence> query = {haystack, needle};
+        query.initializeScoreMatrix(sqn::continuityMatrix, amount);
+        query.setEngine(engine);
+        matches.clear();
+        for (auto match : query.search())
+            matches.push_back(match.needle() + "\n" + match.haystack() + " " + match.score());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cells = (double)haystack.length() * needle.length() * fills * repeats;
+    return cells / seconds / 1e9;
+}
+
+int main(int argc, char** argv) {
+    const char* fileName = argc > 1 ? argv[1] : "data/AAV-CamKII-GCaMP6s-WPRE-SV40.fasta";
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 5;
+    const int amount = 5;
+
+    std::string bases = readBases(fileName);
+    if (bases.empty()) {
+        std::cerr << "No bases read from " << fileName << std::endl;
+        return 1;
+    }
+    Dna5Sequence haystack(bases), needle = "atggctagcatgactggtggacagcaaatgggt";
+
+    /* Every match fills the complete matrix once more, the bit-parallel engine scans once */
+    std::vector<std::string> scalarMatches, vectorMatches, bitMatches;
+    double scalar = run(sqn::Engine::scalar, haystack, needle, amount, amount, repeats, scalarMatches);
+    double vector = run(sqn::Engine::vector, haystack, needle, amount, amount, repeats, vectorMatches);
+    double bits = run(sqn::Engine::bitParallel, haystack, needle, amount, 1, repeats, bitMatches);
+
+    std::cout << "haystack " << haystack.length() << " bases, needle " << needle.length()
+        << " bases, " << amount << " matches, " << sqn::detail::instructionSet() << std::endl;
+    std::cout << "scalar " << scalar << " GCUPS" << std::endl;
+    std::cout << "vector " << vector << " GCUPS (" << vector / scalar << "x)" << std::endl;
+    std::cout << "bit-parallel " << bits << " GCUPS (" << bits / scalar << "x)" << std::endl;
+    if (scalarMatches != vectorMatches) {
+        std::cerr << "Engines report different matches" << std::endl;
+        return 1;
+    }
+    return 0;
+}
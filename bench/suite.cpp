@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined (__unix__) || defined (__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include <sqnmanip/sqn/fzy.hpp>
+
+/**
+ * Result
+ *
+ * @brief
+ * One benchmark run in the layout of Google Benchmark, times are per iteration.
+ */
+struct Result {
+    std::string name;
+    long iterations = 0;
+    double realTime = 0;
+    double cpuTime = 0;
+    double itemsPerSecond = 0;
+    size_t haystack = 0;
+    size_t needle = 0;
+    long hits = -1;
+    long peakRss = 0;
+};
+
+/**
+ * Options
+ *
+ * @brief
+ * Command line options, named after the flags of Google Benchmark where they exist.
+ */
+struct Options {
+    std::string out = "sqnfzy_bench.json";
+    std::string filter;
+    double minTime = 0.5;
+    size_t maxHaystack = 100000000;
+    size_t maxCells = (size_t)1 << 26;
+};
+
+/**
+ * resetPeakRss, peakRss
+ *
+ * @brief
+ * Reset and read the peak resident set size of the process in bytes, on Linux the peak
+ * can be reset so that every benchmark reports its own peak, elsewhere the peak of the
+ * whole process is reported.
+ */
+void resetPeakRss () {
+#if defined (__linux__)
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+#endif
+}
+long peakRss () {
+#if defined (__linux__)
+    std::ifstream status("/proc/self/status");
+    for (std::string line; getline(status, line);)
+        if (line.rfind("VmHWM:", 0) == 0)
+            return std::stol(line.substr(6)) * 1024;
+#endif
+#if defined (__unix__) || defined (__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined (__APPLE__)
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/**
+ * randomBases
+ *
+ * @brief
+ * Synthetic bases drawn uniformly from a, c, g and t.
+ * @param length The amount of bases.
+ * @param seed The seed of the generator, equal seeds give equal bases.
+ * @return The bases as single string.
+ */
+std::string randomBases (size_t length, unsigned seed) {
+    std::mt19937 random(seed);
+    std::string bases(length, 'a');
+    for (char& base : bases)
+        base = "acgt"[random() % 4];
+    return bases;
+}
+
+/**
+ * State
+ *
+ * @brief
+ * The timer of one benchmark, only the time between start and stop is counted so that
+ * every iteration can prepare its query outside of the measurement.
+ */
+class State {
+  public:
+    long hits = -1;
+    double real = 0;
+    double cpu = 0;
+
+    void start () {
+        this->_realStart = std::chrono::steady_clock::now();
+        this->_cpuStart = std::clock();
+    }
+    void stop () {
+        this->real += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - this->_realStart).count();
+        this->cpu += (double)(std::clock() - this->_cpuStart) / CLOCKS_PER_SEC;
+    }
+
+  private:
+    std::chrono::steady_clock::time_point _realStart;
+    std::clock_t _cpuStart = 0;
+};
+
+/**
+ * measure
+ *
+ * @brief
+ * Repeat a benchmark until the minimum time is spent.
+ * @param body Runs one iteration and returns the amount of items it processed.
+ */
+void measure (Result& result, const Options& options, const std::function<double (State&)>& body) {
+    State state;
+    double items = 0;
+    resetPeakRss();
+    while (result.iterations == 0 || state.real < options.minTime) {
+        items += body(state);
+        ++result.iterations;
+    }
+    result.realTime = state.real / result.iterations * 1e9;
+    result.cpuTime = state.cpu / result.iterations * 1e9;
+    result.itemsPerSecond = state.real > 0 ? items / state.real : 0;
+    result.hits = state.hits;
+    result.peakRss = peakRss();
+}
+
+/**
+ * report
+ *
+ * @brief
+ * Print a result as a row of the console table.
+ */
+void report (const Result& result) {
+    std::cout << std::left << std::setw(36) << result.name << std::right
+        << std::setw(16) << std::fixed << std::setprecision(0) << result.realTime << " ns"
+        << std::setw(16) << result.cpuTime << " ns"
+        << std::setw(10) << result.iterations
+        << std::setw(12) << std::setprecision(3) << result.itemsPerSecond / 1e6 << "M/s"
+        << std::setw(10) << result.peakRss / (1 << 20) << " MiB";
+    if (result.hits >= 0)
+        std::cout << " hits=" << result.hits;
+    std::cout << std::endl;
+}
+
+/**
+ * writeJson
+ *
+ * @brief
+ * Write all results in the JSON layout of Google Benchmark so that existing tools can
+ * compare runs, the sizes, hits and peak resident set size are added as counters.
+ */
+void writeJson (const std::vector<Result>& results, const Options& options, const char* executable) {
+    std::ofstream file(options.out);
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    file << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"executable\": \"" << executable << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"instruction_set\": \"" << sqn::detail::instructionSet() << "\",\n"
+#if defined (NDEBUG)
+        << "    \"library_build_type\": \"release\"\n"
+#else
+        << "    \"library_build_type\": \"debug\"\n"
+#endif
+        << "  },\n  \"benchmarks\": [";
+    for (size_t r = 0; r < results.size(); ++r) {
+        const Result& result = results[r];
+        file << (r > 0 ? "," : "") << "\n    {\n"
+            << "      \"name\": \"" << result.name << "\",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << std::setprecision(10)
+            << "      \"real_time\": " << result.realTime << ",\n"
+            << "      \"cpu_time\": " << result.cpuTime << ",\n"
+            << "      \"time_unit\": \"ns\",\n"
+            << "      \"items_per_second\": " << result.itemsPerSecond << ",\n"
+            << "      \"haystack\": " << result.haystack << ",\n"
+            << "      \"needle\": " << result.needle << ",\n";
+        if (result.hits >= 0)
+            file << "      \"hits\": " << result.hits << ",\n";
+        file << "      \"peak_rss_bytes\": " << result.peakRss << "\n    }";
+    }
+    file << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        std::string value = argument.substr(argument.find('=') + 1);
+        if (argument.rfind("--benchmark_out=", 0) == 0)
+            options.out = value;
+        else if (argument.rfind("--benchmark_filter=", 0) == 0)
+            options.filter = value;
+        else if (argument.rfind("--benchmark_min_time=", 0) == 0)
+            options.minTime = std::stod(value);
+        else if (argument.rfind("--max_haystack=", 0) == 0)
+            options.maxHaystack = std::stoull(value);
+        else if (argument.rfind("--max_cells=", 0) == 0)
+            options.maxCells = std::stoull(value);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--benchmark_out=<file>] [--benchmark_filter=<text>]"
+                << " [--benchmark_min_time=<seconds>] [--max_haystack=<bases>] [--max_cells=<cells>]"
+                << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<size_t> haystacks = {1000, 10000, 100000, 1000000, 10000000, 100000000};
+    const std::vector<size_t> needles = {6, 32, 128, 1000};
+    const std::vector<int> amounts = {1, 4, 16};
+    std::vector<Result> results;
+    auto selected = [&](const std::string& name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    };
+    auto run = [&](const std::string& name, size_t length, size_t needleLength, auto body) {
+        if (!selected(name))
+            return;
+        Result result;
+        result.name = name;
+        result.haystack = length;
+        result.needle = needleLength;
+        measure(result, options, body);
+        report(result);
+        results.push_back(result);
+    };
+
+    for (size_t length : haystacks) {
+        if (length > options.maxHaystack)
+            continue;
+        std::string bases = randomBases(length, 42);
+
+        /* Appending raw bases to an empty sequence, items are bases */
+        run("BM_SequenceConstruction/" + std::to_string(length), length, 0,
+            [&](State& state) {
+                state.start();
+                Dna5Sequence sequence;
+                sequence.append(bases.data(), bases.size());
+                state.stop();
+                return (double)length;
+            });
+
+        for (size_t needleLength : needles) {
+            if (needleLength > length)
+                continue;
+            std::string needleBases = randomBases(needleLength, 7);
+            Dna5Sequence needle(needleBases);
+            std::string size = std::to_string(length) + "/" + std::to_string(needleLength);
+            bool fits = length * needleLength <= options.maxCells;
+
+            /* Scoring every cell of a spanned matrix, items are cells */
+            if (fits)
+                run("BM_UpdateMatrix/" + size, length, needleLength,
+                    [&](State& state) {
+                        sqn::FuzzyQuery<Dna5Sequence> query = {Dna5Sequence(bases), needle};
+                        query.initializeScoreMatrix(sqn::continuityMatrix, 1);
+                        query.updateMatrix();
+                        state.start();
+                        query.updateMatrix();
+                        state.stop();
+                        return (double)length * needleLength;
+                    });
+
+            /* Latency of a search for a growing amount of matches, the compact memory mode
+             * fills the matrix once per match and the bit-parallel engine scans once */
+            for (int amount : amounts) {
+                std::string suffix = size + "/" + std::to_string(amount);
+                if (fits)
+                    run("BM_SearchCompact/" + suffix, length, needleLength,
+                        [&](State& state) {
+                            sqn::FuzzyQuery<Dna5Sequence> query = {Dna5Sequence(bases), needle};
+                            query.initializeScoreMatrix(sqn::continuityMatrix, amount);
+                            query.setMemoryMode(sqn::MemoryMode::compact);
+                            state.start();
+                            size_t hits = query.search().size();
+                            state.stop();
+                            state.hits = hits;
+                            return (double)length * needleLength * std::max<size_t>(hits, 1);
+                        });
+                run("BM_SearchBitParallel/" + suffix, length, needleLength,
+                    [&](State& state) {
+                        sqn::FuzzyQuery<Dna5Sequence> query = {Dna5Sequence(bases), needle};
+                        query.initializeScoreMatrix(sqn::continuityMatrix, amount);
+                        query.setEngine(sqn::Engine::bitParallel);
+                        state.start();
+                        size_t hits = query.search().size();
+                        state.stop();
+                        state.hits = hits;
+                        return (double)length * needleLength;
+                    });
+            }
+        }
+    }
+
+    writeJson(results, options, argv[0]);
+    std::cout << "Wrote " << results.size() << " results to " << options.out << std::endl;
+    return 0;
+}
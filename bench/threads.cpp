@@ -0,0 +1,54 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sqnmanip/sqn/fzy.hpp>
+
+/**
+ * run
+ *
+ * @brief
+ * Search the needle in the haystack with an amount of threads filling the matrix.
+ * @param threads The amount of threads used by the query.
+ * @param matches The formatted matches found by the query.
+ * @return The seconds spent searching.
+ */
+double run (unsigned threads, Dna5Sequence& haystack, Dna5Sequence& needle,
+            std::vector<std::string>& matches) {
+    sqn::FuzzyQuery<Dna5Sequence> query = {haystack, needle};
+    query.initializeScoreMatrix(sqn::disparityMatrix, 3);
+    query.setThreads(threads);
+    auto start = std::chrono::steady_clock::now();
+    matches.clear();
+    for (auto match : query.search())
+        matches.push_back(match.needle() + "\n" + match.haystack() + " " + match.score());
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    unsigned maxThreads = argc > 1 ? std::stoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    int length = argc > 2 ? std::stoi(argv[2]) : 200000;
+
+    std::mt19937 random(42);
+    std::string bases(length, 'a');
+    for (char& base : bases)
+        base = "acgt"[random() % 4];
+    Dna5Sequence haystack(bases), needle = "atggctagcatgactggtggacagcaaatgggt";
+
+    std::vector<std::string> serialMatches, matches;
+    double serial = run(1, haystack, needle, serialMatches);
+    std::cout << "haystack " << haystack.length() << " bases, needle " << needle.length() << " bases" << std::endl;
+    std::cout << "threads 1 " << serial << " s" << std::endl;
+    for (unsigned threads = 2; threads <= maxThreads; threads *= 2) {
+        double seconds = run(threads, haystack, needle, matches);
+        std::cout << "threads " << threads << " " << seconds << " s (" << serial / seconds << "x)" << std::endl;
+        if (matches != serialMatches) {
+            std::cerr << "Matches with " << threads << " threads differ" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
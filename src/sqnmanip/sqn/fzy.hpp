@@ -1,13 +1,31 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits>
 #include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #ifndef SQN_FZY_HPP
 #define SQN_FZY_HPP
@@ -104,78 +122,111 @@ namespace sqn
      * DnaSpecification
      *
      * @brief
-     * Base class for DNA alphabet types.
+     * Base class for DNA alphabet types, specifications are stateless and provide
+     * a static constexpr nucleotides table where zero marks characters outside the alphabet.
      */
     class DnaSpecification
     {
-      public:
-        virtual std::map<size_t, unsigned char>& nucleotides () = 0;
     };
 
     /**
      * SequenceIterator
      *
      * @brief
-     * Base class template has the ability to iterate through the elements of sequences.
+     * Base class template has the ability to iterate through the elements of sequences,
+     * it walks the node index of the sequence so that it models a random access iterator.
      */
     template <typename Tp>
     class SequenceIterator
     {
       public:
-        using iterator_category = std::bidirectional_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Tp;
         using difference_type = std::ptrdiff_t;
+        using pointer = Tp*;
+        using reference = Tp&;
 
-        SequenceIterator (SequenceNodeBase<Tp>* position)
+        SequenceIterator ()
+            : _current (nullptr) {};
+        SequenceIterator (SequenceNodeBase<Tp>* const* position)
             : _current (position) {};
 
         /**
-         * operator==, operator!=
+         * operator==, operator!=, operator<, operator>, operator<=, operator>=
          *
          * @brief
-         * Comparing whether iterators are pointing to the same element.
+         * Comparing whether iterators are pointing to the same element or which one comes first.
          * @param other The second iterator for comparison.
          */
         bool
-        operator== (SequenceIterator<Tp> other) const
+        operator== (const SequenceIterator<Tp>& other) const
         {
             return this->_current == other._current;
         }
         bool
-        operator!= (SequenceIterator<Tp> other) const
+        operator!= (const SequenceIterator<Tp>& other) const
         {
             return this->_current != other._current;
         }
+        bool
+        operator< (const SequenceIterator<Tp>& other) const
+        {
+            return this->_current < other._current;
+        }
+        bool
+        operator> (const SequenceIterator<Tp>& other) const
+        {
+            return this->_current > other._current;
+        }
+        bool
+        operator<= (const SequenceIterator<Tp>& other) const
+        {
+            return this->_current <= other._current;
+        }
+        bool
+        operator>= (const SequenceIterator<Tp>& other) const
+        {
+            return this->_current >= other._current;
+        }
 
         /**
-         * operator+, operator-
+         * operator+, operator-, operator+=, operator-=
          *
          * @brief
          * Iterate an iterator forward by addition and backward by subtraction.
          * @param summand, subtrahend The amount of forward backward operations.
          */
         SequenceIterator<Tp>
-        operator+ (unsigned int summand)
+        operator+ (difference_type summand) const
         {
-            SequenceIterator<Tp> tmp (this->_current);
-            while (summand > 0)
-            {
-                tmp._current
-                    = static_cast<SequenceNodeBase<Tp>*> (tmp._current->_next);
-                --summand;
-            }
-            return tmp;
+            return SequenceIterator<Tp> (this->_current + summand);
+        }
+        friend SequenceIterator<Tp>
+        operator+ (difference_type summand, const SequenceIterator<Tp>& other)
+        {
+            return other + summand;
         }
         SequenceIterator<Tp>
-        operator- (unsigned int subtrahend)
+        operator- (difference_type subtrahend) const
         {
-            SequenceIterator<Tp> tmp (this->_current);
-            while (subtrahend > 0)
-            {
-                tmp._current
-                    = static_cast<SequenceNodeBase<Tp>*> (tmp._current->_prev);
-                --subtrahend;
-            }
-            return tmp;
+            return SequenceIterator<Tp> (this->_current - subtrahend);
+        }
+        difference_type
+        operator- (const SequenceIterator<Tp>& other) const
+        {
+            return this->_current - other._current;
+        }
+        SequenceIterator<Tp>&
+        operator+= (difference_type summand)
+        {
+            this->_current += summand;
+            return *this;
+        }
+        SequenceIterator<Tp>&
+        operator-= (difference_type subtrahend)
+        {
+            this->_current -= subtrahend;
+            return *this;
         }
 
         /**
@@ -188,15 +239,13 @@ namespace sqn
         SequenceIterator<Tp>&
         operator++ ()
         {
-            this->_current
-                = static_cast<SequenceNodeBase<Tp>*> (this->_current->_next);
+            ++this->_current;
             return *this;
         }
         SequenceIterator<Tp>&
         operator-- ()
         {
-            this->_current
-                = static_cast<SequenceNodeBase<Tp>*> (this->_current->_prev);
+            --this->_current;
             return *this;
         }
         SequenceIterator<Tp>
@@ -215,7 +264,7 @@ namespace sqn
         }
 
         /**
-         * operator*, operator->
+         * operator*, operator->, operator[]
          *
          * @brief
          * Dereference the current iterator and access the node element.
@@ -223,61 +272,174 @@ namespace sqn
         Tp&
         operator* () const
         {
-            return this->_current->_data;
+            return (*this->_current)->_data;
         }
         Tp*
-        operator-> ()
+        operator-> () const
+        {
+            return &(*this->_current)->_data;
+        }
+        Tp&
+        operator[] (difference_type offset) const
+        {
+            return this->_current[offset]->_data;
+        }
+
+      private:
+        SequenceNodeBase<Tp>* const* _current;
+    };
+
+    /**
+     * SequenceArena
+     *
+     * @brief
+     * Memory for the nodes of many sequences that are discarded together, for example all
+     * sequences built for one query. Nodes are carved from large blocks and released all at
+     * once when the arena is reset or destroyed, sequences must not outlive their arena.
+     */
+    class SequenceArena
+    {
+      public:
+        explicit SequenceArena (size_t blockBytes = 1 << 16)
+            : _blockBytes (blockBytes), _used (0), _size (0) {}
+        SequenceArena (const SequenceArena&) = delete;
+        SequenceArena& operator= (const SequenceArena&) = delete;
+
+        /**
+         * allocate()
+         *
+         * @brief
+         * Take memory from the current block, a new block is allocated when it is full.
+         * @param bytes, alignment The size and alignment of the memory.
+         */
+        void*
+        allocate (size_t bytes, size_t alignment)
+        {
+            size_t offset = (this->_used + alignment - 1) & ~(alignment - 1);
+            if (this->_blocks.empty () || offset + bytes > this->_size)
+            {
+                this->_size = std::max (this->_blockBytes, bytes + alignment);
+                this->_blocks.emplace_back (new unsigned char[this->_size]);
+                offset = (alignment - (size_t)this->_blocks.back ().get () % alignment) % alignment;
+            }
+            this->_used = offset + bytes;
+            return this->_blocks.back ().get () + offset;
+        }
+
+        /**
+         * reset()
+         *
+         * @brief
+         * Release the memory of all sequences built in the arena.
+         */
+        void
+        reset ()
         {
-            return this->_current;
+            this->_blocks.clear ();
+            this->_used = 0;
+            this->_size = 0;
         }
 
       private:
-        SequenceNodeBase<Tp>* _current;
+        std::vector<std::unique_ptr<unsigned char[]>> _blocks;
+        size_t _blockBytes;
+        size_t _used;
+        size_t _size;
     };
 
     /**
      * Sequence
      *
      * @brief
-     * Class template that represents sequences of DNA alphabet types.
+     * Class template that represents sequences of DNA alphabet types. A sequence owns its
+     * nodes, they are taken from blocks that grow with the sequence or from an arena shared
+     * with other sequences, and copies are deep.
      */
     template <AssignableTo<char> Tp>
     class Sequence
     {
       public:
         Sequence ()
-            : _begin (nullptr), _end (nullptr), _size (0) {};
+            : _size (0), _begin (nullptr), _end (nullptr), _free (nullptr), _freeEnd (nullptr),
+              _arena (nullptr) {};
+        explicit Sequence (SequenceArena& arena)
+            : Sequence ()
+        {
+            static_assert (std::is_trivially_destructible_v<Tp>,
+                "Elements in an arena are released without destruction");
+            this->_arena = &arena;
+        }
         Sequence (const char* other)
+            : Sequence ()
         {
-            this->_size = 0;
-            this->_begin = nullptr;
-            this->_end = nullptr;
-            while (other[this->_size] != '\0')
-            {
-                SequenceNodeBase<Tp>* node = new SequenceNodeBase<Tp> ();
-                node->_data = other[this->_size];
-                this->append (node);
-                ++this->_size;
-            }
+            this->assign (other, strlen (other));
         }
         Sequence (std::string other)
+            : Sequence ()
         {
-            this->_size = 0;
-            this->_begin = nullptr;
-            this->_end = nullptr;
-            for (std::string::size_type i = 0; i < other.size(); i++)
+            this->assign (other.data (), other.size ());
+        }
+        Sequence (const Sequence<Tp>& other)
+            : Sequence ()
+        {
+            this->_arena = other._arena;
+            this->reserve (other._size);
+            for (size_t i = 0; i < other._size; ++i)
             {
-                SequenceNodeBase<Tp>* node = new SequenceNodeBase<Tp> ();
+                SequenceNodeBase<Tp>* node = this->node ();
                 node->_data = other[i];
                 this->append (node);
-                ++this->_size;
             }
+            this->_size = other._size;
         }
-        Sequence (const Sequence<Tp>& other)
+        Sequence (Sequence<Tp>&& other) noexcept
+            : Sequence ()
         {
-            this->_begin = other._begin;
-            this->_end = other._end;
-            this->_size = other._size;
+            this->swap (other);
+        }
+
+        /**
+         * operator=
+         *
+         * @brief
+         * Copy or move another sequence into this one.
+         */
+        Sequence<Tp>&
+        operator= (Sequence<Tp> other) noexcept
+        {
+            this->swap (other);
+            return *this;
+        }
+        void
+        swap (Sequence<Tp>& other) noexcept
+        {
+            std::swap (this->_size, other._size);
+            std::swap (this->_begin, other._begin);
+            std::swap (this->_end, other._end);
+            std::swap (this->_index, other._index);
+            std::swap (this->_blocks, other._blocks);
+            std::swap (this->_free, other._free);
+            std::swap (this->_freeEnd, other._freeEnd);
+            std::swap (this->_arena, other._arena);
+        }
+
+        /**
+         * reserve()
+         *
+         * @brief
+         * Prepare room for more elements so that appending them allocates nothing.
+         * @param count The amount of elements.
+         */
+        void
+        reserve (size_t count)
+        {
+            this->_index.reserve (this->_size + count);
+            if (this->_arena == nullptr && (size_t)(this->_freeEnd - this->_free) < count)
+            {
+                this->_blocks.emplace_back (new SequenceNodeBase<Tp>[count] ());
+                this->_free = this->_blocks.back ().get ();
+                this->_freeEnd = this->_free + count;
+            }
         }
 
         /**
@@ -290,22 +452,28 @@ namespace sqn
         Sequence<Tp>&
         operator+= (const char* summand)
         {
-            size_t index = 0;
-            while (summand[index] != '\0')
-            {
-                SequenceNodeBase<Tp>* node = new SequenceNodeBase<Tp> ();
-                node->_data = summand[index];
-                this->append (node);
-                ++this->_size;
-                ++index;
-            }
+            this->assign (summand, strlen (summand));
             return *this;
         }
+
+        /**
+         * append()
+         *
+         * @brief
+         * Append a range of raw characters, used by readers that stream bases from a file.
+         * @param other The first character of the range.
+         * @param count The amount of characters.
+         */
+        void
+        append (const char* other, size_t count)
+        {
+            this->assign (other, count);
+        }
         template <typename Ts>
         Sequence<Tp>&
         operator+= (Ts summand)
         {
-            SequenceNodeBase<Tp>* node = new SequenceNodeBase<Tp> ();
+            SequenceNodeBase<Tp>* node = this->node ();
             node->_data = summand;
             this->append (node);
             ++this->_size;
@@ -322,47 +490,40 @@ namespace sqn
         Tp&
         operator[] (size_t index)
         {
-            SequenceNodeBase<Tp>* node = this->_begin;
-            for (size_t i = 0; i < index; ++i)
-                node = static_cast<SequenceNodeBase<Tp>*> (node->_next);
-            return node->_data;
+            return this->_index[index]->_data;
+        }
+        const Tp&
+        operator[] (size_t index) const
+        {
+            return this->_index[index]->_data;
         }
 
         /**
          * begin(), end()
          *
          * @brief
-         * Retrieve an iterator pointing to the begin or end of the sequence.
+         * Retrieve an iterator pointing to the begin or one past the end of the sequence.
          * @return The SequenceIterator with that position.
          */
         SequenceIterator<Tp>
         begin ()
         {
-            return SequenceIterator<Tp> (this->_begin);
+            return SequenceIterator<Tp> (this->_index.data ());
         }
         SequenceIterator<Tp>
         end ()
         {
-            return SequenceIterator<Tp> (this->_end);
+            return SequenceIterator<Tp> (this->_index.data () + this->_size);
         }
         size_t
-        length ()
+        length () const
         {
             return this->_size;
         }
         void
         reverse ()
         {
-            auto first = this->begin ();
-            auto last = this->end ();
-
-            if (first == last - 1 || first + 1 == last)
-                return std::swap (*first, *last);
-
-            while (first != last && first != last - 1)
-                std::swap (*first++, *last--);
-
-            std::swap (*first, *last);
+            std::reverse (this->begin (), this->end ());
         }
         std::string
         toString ()
@@ -378,6 +539,58 @@ namespace sqn
         }
 
       private:
+        /**
+         * assign()
+         *
+         * @brief
+         * Append raw characters, alphabet types that can translate whole ranges
+         * at once are translated in bulk before the nodes are linked.
+         */
+        void
+        assign (const char* other, size_t count)
+        {
+            this->reserve (count);
+            if constexpr (requires (Tp* out) { Tp::assign (other, count, out); })
+            {
+                std::vector<Tp> elements (count);
+                Tp::assign (other, count, elements.data ());
+                for (size_t i = 0; i < count; ++i)
+                {
+                    SequenceNodeBase<Tp>* node = this->node ();
+                    node->_data = elements[i];
+                    this->append (node);
+                    ++this->_size;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    SequenceNodeBase<Tp>* node = this->node ();
+                    node->_data = other[i];
+                    this->append (node);
+                    ++this->_size;
+                }
+            }
+        }
+
+        /**
+         * node()
+         *
+         * @brief
+         * A new unlinked node from the arena of the sequence, or from its last block which
+         * is replaced by one as large as the sequence when it is used up.
+         */
+        SequenceNodeBase<Tp>*
+        node ()
+        {
+            if (this->_arena != nullptr)
+                return new (this->_arena->allocate (sizeof (SequenceNodeBase<Tp>),
+                    alignof (SequenceNodeBase<Tp>))) SequenceNodeBase<Tp> ();
+            if (this->_free == this->_freeEnd)
+                this->reserve (std::max (this->_size, (size_t)16));
+            return this->_free++;
+        }
         void
         append (SequenceNodeBase<Tp> *node)
         {
@@ -392,289 +605,4964 @@ namespace sqn
                 this->_begin = node;
                 this->_end = node;
             }
+            this->_index.push_back (node);
         }
         size_t _size;
         SequenceNodeBase<Tp>* _begin;
         SequenceNodeBase<Tp>* _end;
+        std::vector<SequenceNodeBase<Tp>*> _index;
+        std::vector<std::unique_ptr<SequenceNodeBase<Tp>[]>> _blocks;
+        SequenceNodeBase<Tp>* _free;
+        SequenceNodeBase<Tp>* _freeEnd;
+        SequenceArena* _arena;
     };
 
+    static_assert (std::random_access_iterator<SequenceIterator<char>>);
+
     /**
-     * Dna5Specification
+     * PackedSequenceIterator
      *
      * @brief
-     * The five letter DNA alphabet of A,C,G,T, the unknown character N and a gap character.
+     * Class template has the ability to iterate through the elements of packed sequences,
+     * elements are decoded on access and therefore returned by value.
      */
-    class Dna5Specification : DnaSpecification
+    template <typename Ts>
+    class PackedSequenceIterator
     {
       public:
-        std::map<size_t, unsigned char>&
-        nucleotides ()
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename Ts::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        PackedSequenceIterator ()
+            : _sequence (nullptr), _position (0) {};
+        PackedSequenceIterator (const Ts* sequence, size_t position)
+            : _sequence (sequence), _position (position) {};
+
+        /**
+         * operator==, operator!=, operator<, operator>, operator<=, operator>=
+         *
+         * @brief
+         * Comparing whether iterators are pointing to the same element or which one comes first.
+         * @param other The second iterator for comparison.
+         */
+        bool
+        operator== (const PackedSequenceIterator<Ts>& other) const
         {
-            return this->_dna5nucleotides;
+            return this->_position == other._position;
+        }
+        bool
+        operator!= (const PackedSequenceIterator<Ts>& other) const
+        {
+            return this->_position != other._position;
+        }
+        bool
+        operator< (const PackedSequenceIterator<Ts>& other) const
+        {
+            return this->_position < other._position;
+        }
+        bool
+        operator> (const PackedSequenceIterator<Ts>& other) const
+        {
+            return this->_position > other._position;
+        }
+        bool
+        operator<= (const PackedSequenceIterator<Ts>& other) const
+        {
+            return this->_position <= other._position;
+        }
+        bool
+        operator>= (const PackedSequenceIterator<Ts>& other) const
+        {
+            return this->_position >= other._position;
         }
 
-      private:
-        std::map<size_t, unsigned char> _dna5nucleotides
-            = { { 65, 'A' }, { 67, 'C' }, {  71, 'G' }, {  84, 'T' }, { 45, '-' },
-                { 97, 'A' }, { 99, 'C' }, { 103, 'G' }, { 116, 'T' } };
-    };
-
-    /**
-     * SimpleType
-     *
-     * @brief
-     * Class template that stores the values of an instance according to its specification.
-     */
-    template <typename TValue, DerivedFrom<DnaSpecification> TSpec>
-    class SimpleType
-    {
-      public:
-        TValue
-        getNucleotides (const size_t& key,
-                        const TValue& value)
+        /**
+         * operator+, operator-
+         *
+         * @brief
+         * Iterate an iterator forward by addition and backward by subtraction.
+         * @param summand, subtrahend The amount of forward backward operations.
+         */
+        PackedSequenceIterator<Ts>
+        operator+ (difference_type summand) const
         {
-            typename std::map<size_t, TValue>::const_iterator it
-                = this->_specification.nucleotides ().find (key);
-            if (it == this->_specification.nucleotides ().end ())
-                return value;
-            else
-                return it->second;
+            return PackedSequenceIterator<Ts> (this->_sequence, this->_position + summand);
+        }
+        PackedSequenceIterator<Ts>
+        operator- (difference_type subtrahend) const
+        {
+            return PackedSequenceIterator<Ts> (this->_sequence, this->_position - subtrahend);
+        }
+        friend PackedSequenceIterator<Ts>
+        operator+ (difference_type summand, const PackedSequenceIterator<Ts>& other)
+        {
+            return other + summand;
+        }
+        difference_type
+        operator- (const PackedSequenceIterator<Ts>& other) const
+        {
+            return (difference_type)this->_position - (difference_type)other._position;
+        }
+        PackedSequenceIterator<Ts>&
+        operator+= (difference_type summand)
+        {
+            this->_position += summand;
+            return *this;
+        }
+        PackedSequenceIterator<Ts>&
+        operator-= (difference_type subtrahend)
+        {
+            this->_position -= subtrahend;
+            return *this;
         }
 
         /**
-         * operator=
+         * operator++, operator--
          *
          * @brief
-         * Assign a value with specification restriction.
+         * Iterate an iterator forward or backward, this would be equal to either
+         * operator+(1) or operator-(1) depending on prefix or postfix.
          */
-        template <typename T>
-        inline SimpleType&
-        operator= (T const& other)
+        PackedSequenceIterator<Ts>&
+        operator++ ()
         {
-            this->_value = this->getNucleotides ((size_t)other, static_cast<TValue> ('N'));
+            ++this->_position;
             return *this;
         }
+        PackedSequenceIterator<Ts>&
+        operator-- ()
+        {
+            --this->_position;
+            return *this;
+        }
+        PackedSequenceIterator<Ts>
+        operator++ (int)
+        {
+            PackedSequenceIterator<Ts> tmp (*this);
+            ++this->_position;
+            return tmp;
+        }
+        PackedSequenceIterator<Ts>
+        operator-- (int)
+        {
+            PackedSequenceIterator<Ts> tmp (*this);
+            --this->_position;
+            return tmp;
+        }
 
-        operator char () const { return (char)this->_value; }
+        /**
+         * operator*, operator[]
+         *
+         * @brief
+         * Dereference the current iterator and decode the element.
+         */
+        value_type
+        operator* () const
+        {
+            return (*this->_sequence)[this->_position];
+        }
+        value_type
+        operator[] (difference_type offset) const
+        {
+            return (*this->_sequence)[this->_position + offset];
+        }
 
       private:
-        TValue _value;
-        TSpec _specification;
+        const Ts* _sequence;
+        size_t _position;
     };
 
     /**
-     * Item
+     * PackedSequence
      *
      * @brief
-     * Class template that stores part of a sequence with start and end.
+     * Class template that stores sequences of DNA alphabet types contiguously with two bits
+     * per base, the unknown character N and gaps are flagged in a side bitmap which is only
+     * allocated once the first of them is stored.
      */
-    template <typename Tp>
-    class Item
+    template <AssignableTo<char> Tp>
+    class PackedSequence
     {
       public:
-        Item () = default;
-        Item (Tp sequence, size_t start, size_t end)
-            : _sequence (sequence), _start (start), _end (end)
+        using value_type = Tp;
+
+        PackedSequence ()
+            : _size (0) {};
+        PackedSequence (const char* other)
+            : _size (0)
         {
+            this->assign (other, strlen (other));
         }
-        Item (const Item &other)
-            : _sequence (other._sequence), _start (other._start),
-              _end (other._end)
+        PackedSequence (const std::string& other)
+            : _size (0)
+        {
+            this->assign (other.data (), other.size ());
+        }
+        PackedSequence (const PackedSequence<Tp>& other) = default;
+        PackedSequence (PackedSequence<Tp>&& other) noexcept
+            : PackedSequence ()
         {
+            this->swap (other);
         }
 
-        Tp _sequence;
-        size_t _start;
-        size_t _end;
-    };
+        /**
+         * operator=
+         *
+         * @brief
+         * Copy or move another sequence into this one.
+         */
+        PackedSequence<Tp>&
+        operator= (PackedSequence<Tp> other) noexcept
+        {
+            this->swap (other);
+            return *this;
+        }
+        void
+        swap (PackedSequence<Tp>& other) noexcept
+        {
+            std::swap (this->_size, other._size);
+            std::swap (this->_bases, other._bases);
+            std::swap (this->_special, other._special);
+        }
+
+        /**
+         * operator+=
+         *
+         * @brief
+         * Append to the current sequence.
+         * @param summand The element or sequence to append.
+         */
+        PackedSequence<Tp>&
+        operator+= (const char* summand)
+        {
+            this->assign (summand, strlen (summand));
+            return *this;
+        }
+
+        /**
+         * append()
+         *
+         * @brief
+         * Append a range of raw characters, used by readers that stream bases from a file.
+         * @param other The first character of the range.
+         * @param count The amount of characters.
+         */
+        void
+        append (const char* other, size_t count)
+        {
+            this->assign (other, count);
+        }
+        template <typename Ts>
+        PackedSequence<Tp>&
+        operator+= (Ts summand)
+        {
+            Tp element;
+            element = summand;
+            this->append (PackedSequence<Tp>::encode ((char)element));
+            return *this;
+        }
+
+        /**
+         * operator[]
+         *
+         * @brief
+         * Decode the current sequence element at a specified index.
+         * @param index The position in the sequence.
+         */
+        Tp
+        operator[] (size_t index) const
+        {
+            Tp element;
+            element = PackedSequence<Tp>::decode (this->code (index));
+            return element;
+        }
+
+        /**
+         * begin(), end()
+         *
+         * @brief
+         * Retrieve an iterator pointing to the begin or one past the end of the sequence.
+         * @return The PackedSequenceIterator with that position.
+         */
+        PackedSequenceIterator<PackedSequence<Tp>>
+        begin () const
+        {
+            return PackedSequenceIterator<PackedSequence<Tp>> (this, 0);
+        }
+        PackedSequenceIterator<PackedSequence<Tp>>
+        end () const
+        {
+            return PackedSequenceIterator<PackedSequence<Tp>> (this, this->_size);
+        }
+        size_t
+        length () const
+        {
+            return this->_size;
+        }
+        void
+        reverse ()
+        {
+            for (size_t first = 0, last = this->_size; first + 1 < last; ++first, --last)
+            {
+                unsigned char code = this->code (first);
+                this->store (first, this->code (last - 1));
+                this->store (last - 1, code);
+            }
+        }
+        std::string
+        toString () const
+        {
+            std::string result (this->_size, '\0');
+            for (size_t i = 0; i < this->_size; ++i)
+                result[i] = PackedSequence<Tp>::decode (this->code (i));
+            return result;
+        }
+
+      private:
+        /*
+         * Codes 0 to 3 are the bases A, C, G, T stored in the two bit words,
+         * codes 4 and 5 are N and gap which set the side bitmap and keep their
+         * low bit in the two bit words to tell them apart.
+         */
+        static constexpr unsigned char _unknown = 4;
+        static constexpr unsigned char _gap = 5;
+
+        static unsigned char
+        encode (char value)
+        {
+            return PackedSequence<Tp>::table ()[(unsigned char)value];
+        }
+        static char
+        decode (unsigned char code)
+        {
+            return "ACGTN-"[code];
+        }
+
+        /**
+         * table()
+         *
+         * @brief
+         * Lookup from raw characters to codes, characters pass through the
+         * alphabet specification of Tp first so that e.g. lower case is folded.
+         */
+        static const std::array<unsigned char, 256>&
+        table ()
+        {
+            static const std::array<unsigned char, 256> codes = [] {
+                std::array<unsigned char, 256> result;
+                for (size_t c = 0; c < result.size (); ++c)
+                {
+                    Tp element;
+                    element = (char)c;
+                    switch ((char)element)
+                    {
+                        case 'A': case 'a': result[c] = 0; break;
+                        case 'C': case 'c': result[c] = 1; break;
+                        case 'G': case 'g': result[c] = 2; break;
+                        case 'T': case 't': result[c] = 3; break;
+                        case '-': result[c] = PackedSequence<Tp>::_gap; break;
+                        default: result[c] = PackedSequence<Tp>::_unknown; break;
+                    }
+                }
+                return result;
+            } ();
+            return codes;
+        }
+
+        unsigned char
+        code (size_t index) const
+        {
+            unsigned char code = (this->_bases[index >> 5] >> ((index & 31) << 1)) & 3;
+            if (!this->_special.empty ()
+                && (this->_special[index >> 6] >> (index & 63)) & 1)
+                return PackedSequence<Tp>::_unknown + (code & 1);
+            return code;
+        }
+        void
+        store (size_t index, unsigned char code)
+        {
+            uint64_t shift = (index & 31) << 1;
+            this->_bases[index >> 5] = (this->_bases[index >> 5] & ~((uint64_t)3 << shift))
+                | ((uint64_t)(code & 3) << shift);
+            if (code >= PackedSequence<Tp>::_unknown && this->_special.empty ())
+                this->_special.resize ((this->_bases.size () + 1) / 2, 0);
+            if (!this->_special.empty ())
+            {
+                uint64_t bit = (uint64_t)1 << (index & 63);
+                if (code >= PackedSequence<Tp>::_unknown)
+                    this->_special[index >> 6] |= bit;
+                else
+                    this->_special[index >> 6] &= ~bit;
+            }
+        }
+        void
+        append (unsigned char code)
+        {
+            if ((this->_size & 31) == 0)
+            {
+                this->_bases.push_back (0);
+                if (!this->_special.empty () && (this->_size & 63) == 0)
+                    this->_special.push_back (0);
+            }
+            this->store (this->_size++, code);
+        }
+
+        /**
+         * assign()
+         *
+         * @brief
+         * Append raw characters, whole words of 32 bases are assembled in a register
+         * and written at once so that a chromosome is packed in a single pass.
+         */
+        void
+        assign (const char* other, size_t count)
+        {
+            const std::array<unsigned char, 256>& codes = PackedSequence<Tp>::table ();
+            size_t index = 0;
+            while (index < count && (this->_size & 31) != 0)
+                this->append (codes[(unsigned char)other[index++]]);
+
+            size_t words = (this->_size + count - index + 31) / 32;
+            if (words > this->_bases.capacity ())
+                this->_bases.reserve (std::max (words, 2 * this->_bases.capacity ()));
+            while (count - index >= 32)
+            {
+                uint64_t word = 0;
+                uint64_t special = 0;
+                for (size_t k = 0; k < 32; ++k)
+                {
+                    uint64_t code = codes[(unsigned char)other[index + k]];
+                    word |= (code & 3) << (k << 1);
+                    special |= (code >> 2) << k;
+                }
+                this->_bases.push_back (word);
+                if (special != 0 || !this->_special.empty ())
+                {
+                    this->_special.resize ((this->_bases.size () + 1) / 2, 0);
+                    this->_special[this->_size >> 6] |= special << (this->_size & 63);
+                }
+                this->_size += 32;
+                index += 32;
+            }
+
+            while (index < count)
+                this->append (codes[(unsigned char)other[index++]]);
+        }
+
+        size_t _size;
+        std::vector<uint64_t> _bases;
+        std::vector<uint64_t> _special;
+    };
+
+    static_assert (std::random_access_iterator<PackedSequenceIterator<PackedSequence<char>>>);
 
     /**
-     * Match
+     * Dna5Specification
      *
      * @brief
-     * Class template that stores a sequence match with haystack and needle.
+     * The five letter DNA alphabet of A,C,G,T, the unknown character N and a gap character.
      */
-    template <typename Tp>
-    class Match
+    class Dna5Specification : DnaSpecification
     {
       public:
-        Match () = default;
-        Match (Tp sequenceNeedle, Tp sequenceHaystack, int score,
-               size_t startNeedle, size_t endNeedle,
-               size_t startHaystack, size_t endHaystack,
-               std::string (*parser)(Item<Tp>&))
+        static constexpr unsigned char unknown = 'N';
+
+        static constexpr std::array<unsigned char, 256> nucleotides = [] {
+            std::array<unsigned char, 256> result {};
+            result['A'] = 'A'; result['C'] = 'C'; result['G'] = 'G'; result['T'] = 'T';
+            result['a'] = 'A'; result['c'] = 'C'; result['g'] = 'G'; result['t'] = 'T';
+            result['-'] = '-';
+            return result;
+        } ();
+
+        static constexpr std::array<unsigned char, 256> translation = [] {
+            std::array<unsigned char, 256> result {};
+            for (size_t c = 0; c < result.size (); ++c)
+                result[c] = nucleotides[c] != 0 ? nucleotides[c] : unknown;
+            return result;
+        } ();
+
+        /**
+         * translate()
+         *
+         * @brief
+         * Translate raw characters to nucleotides, the range version is written without
+         * branches or lookups so that it is vectorized when translating whole sequences.
+         * @param value, first The character or range of characters to translate.
+         * @param count The amount of characters in the range.
+         * @param out The destination of the translated range.
+         */
+        static constexpr unsigned char
+        translate (unsigned char value)
         {
-            this->_haystack
-                = Item<Tp> (sequenceHaystack, startHaystack, endHaystack);
-            this->_needle
-                = Item<Tp> (sequenceNeedle, startNeedle, endNeedle);
-            this->_score = score;
-            this->_parser = parser;
+            return translation[value];
+        }
+        template <typename TOut>
+        static void
+        translate (const char* first, size_t count, TOut* out)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                unsigned char value = (unsigned char)first[i];
+                unsigned char lower = value | 0x20;
+                unsigned char result = unknown;
+                result = lower == 'a' ? 'A' : result;
+                result = lower == 'c' ? 'C' : result;
+                result = lower == 'g' ? 'G' : result;
+                result = lower == 't' ? 'T' : result;
+                result = value == '-' ? '-' : result;
+                out[i] = result;
+            }
+        }
+    };
+
+    /**
+     * SimpleType
+     *
+     * @brief
+     * Class template that stores the values of an instance according to its specification,
+     * the specification is only used statically so an instance is exactly one value wide.
+     */
+    template <typename TValue, DerivedFrom<DnaSpecification> TSpec>
+    class SimpleType
+    {
+      public:
+        static constexpr TValue
+        getNucleotides (const size_t& key,
+                        const TValue& value)
+        {
+            if (key >= TSpec::nucleotides.size () || TSpec::nucleotides[key] == 0)
+                return value;
+            else
+                return TSpec::nucleotides[key];
         }
 
         /**
-         * haystack()
+         * operator=
          *
          * @brief
-         * Get part of the haystack sequence that was matched with the needle.
-         * @return String representation of the match.
+         * Assign a value with specification restriction.
          */
-        std::string
-        haystack ()
+        inline SimpleType&
+        operator= (char other)
         {
-            if (this->_parser)
+            this->_value = TSpec::translate ((unsigned char)other);
+            return *this;
+        }
+        template <typename T>
+        inline SimpleType&
+        operator= (T const& other)
+        {
+            this->_value = this->getNucleotides ((size_t)other, static_cast<TValue> (TSpec::unknown));
+            return *this;
+        }
+
+        operator char () const { return (char)this->_value; }
+
+        /**
+         * assign()
+         *
+         * @brief
+         * Assign a whole range of characters with specification restriction at once.
+         * @param first The characters to assign.
+         * @param count The amount of characters.
+         * @param out The destination elements.
+         */
+        static void
+        assign (const char* first, size_t count, SimpleType* out)
+        {
+            TValue values[256];
+            for (size_t offset = 0; offset < count; offset += 256)
             {
-                return this->_parser(this->_haystack);
+                size_t chunk = std::min (count - offset, (size_t)256);
+                TSpec::translate (first + offset, chunk, values);
+                for (size_t i = 0; i < chunk; ++i)
+                    out[offset + i]._value = values[i];
             }
-            else
+        }
+
+      private:
+        TValue _value;
+    };
+
+    /**
+     * ReverseComplement
+     *
+     * @brief
+     * Class template that views a sequence as its reverse complement without copying it,
+     * every element is complemented when it is read. Characters other than nucleotides
+     * and IUPAC codes read as they are.
+     */
+    template <typename Ts>
+    class ReverseComplement
+    {
+      public:
+        ReverseComplement (const Ts& sequence)
+            : _sequence (&sequence) {}
+
+        /**
+         * operator[]
+         *
+         * @brief
+         * The complement of the element at the mirrored index of the sequence.
+         * @param index The position in the reverse complement.
+         */
+        char
+        operator[] (size_t index) const
+        {
+            return ReverseComplement::complement (
+                (char)(*this->_sequence)[this->_sequence->length () - 1 - index]);
+        }
+        size_t
+        length () const
+        {
+            return this->_sequence->length ();
+        }
+
+        /**
+         * complement()
+         *
+         * @brief
+         * Complement a single base, the case is kept.
+         */
+        static constexpr char
+        complement (char value)
+        {
+            return (char)ReverseComplement::complements[(unsigned char)value];
+        }
+
+      private:
+        static constexpr std::array<unsigned char, 256> complements = [] {
+            std::array<unsigned char, 256> result {};
+            for (size_t c = 0; c < result.size (); ++c)
+                result[c] = (unsigned char)c;
+            const char* pairs = "ATCGRYKMBVDHatcgrykmbvdh";
+            for (size_t k = 0; pairs[k] != '\0'; k += 2)
             {
-                return this->_haystack._sequence.toString () + ' ' +
-                    "from " + std::to_string(this->_haystack._start) + " to "
-                    + std::to_string(this->_haystack._end);
+                result[(unsigned char)pairs[k]] = pairs[k + 1];
+                result[(unsigned char)pairs[k + 1]] = pairs[k];
             }
+            return result;
+        } ();
+
+        const Ts* _sequence;
+    };
+
+    /**
+     * Strand
+     *
+     * @brief
+     * The strand of the haystack a match lies on, or the strands a query searches. A match
+     * on the reverse strand aligns the reverse complement of the needle with the haystack.
+     */
+    enum class Strand
+    {
+        forward,
+        reverse,
+        both
+    };
+
+    /**
+     * Item
+     *
+     * @brief
+     * Class template that stores part of a sequence with start and end.
+     */
+    template <typename Tp>
+    class Item
+    {
+      public:
+        Item () = default;
+        Item (Tp sequence, size_t start, size_t end)
+            : _sequence (std::move (sequence)), _start (start), _end (end)
+        {
+        }
+        Item (const Item &other)
+            : _sequence (other._sequence), _start (other._start),
+              _end (other._end)
+        {
+        }
+
+        Tp _sequence;
+        size_t _start;
+        size_t _end;
+    };
+
+    namespace detail
+    {
+        template <typename Tp>
+        struct Haystack;
+
+        /**
+         * EditScript
+         *
+         * @brief
+         * Collect the operations of an alignment from its end to its start, runs of the same
+         * operation are counted and written as CIGAR once the alignment is complete.
+         */
+        class EditScript
+        {
+          public:
+            void
+            push (char operation)
+            {
+                if (operation != this->_operation)
+                {
+                    this->flush ();
+                    this->_operation = operation;
+                }
+                ++this->_count;
+            }
+            std::string
+            cigar ()
+            {
+                this->flush ();
+                std::reverse (this->_reversed.begin (), this->_reversed.end ());
+                return this->_reversed;
+            }
+
+          private:
+            void
+            flush ()
+            {
+                if (this->_count == 0)
+                    return;
+                this->_reversed += this->_operation;
+                for (size_t count = this->_count; count > 0; count /= 10)
+                    this->_reversed += (char)('0' + count % 10);
+                this->_count = 0;
+            }
+
+            std::string _reversed;
+            char _operation = 0;
+            size_t _count = 0;
+        };
+    }
+
+    /**
+     * Match
+     *
+     * @brief
+     * Class template that stores a sequence match with haystack and needle as positions and
+     * a CIGAR edit script, M for aligned characters, I for needle characters against a gap
+     * and D for haystack characters against a gap. The aligned sequences are only rendered
+     * from the searched sequences when the match is printed.
+     */
+    template <typename Tp>
+    class Match
+    {
+      public:
+        Match () = default;
+        Match (std::shared_ptr<const Tp> needleSource,
+               std::shared_ptr<const detail::Haystack<Tp>> haystackSource,
+               std::string cigar, int score,
+               size_t startNeedle, size_t endNeedle,
+               size_t startHaystack, size_t endHaystack,
+               std::string (*parser)(Item<Tp>&))
+            : _needleSource (needleSource), _haystackSource (haystackSource),
+              _needleBegin (startNeedle - 1), _haystackBegin (startHaystack - 1)
+        {
+            this->_haystack._start = startHaystack;
+            this->_haystack._end = endHaystack;
+            this->_needle._start = startNeedle;
+            this->_needle._end = endNeedle;
+            this->_cigar = cigar;
+            this->_score = score;
+            this->_parser = parser;
+        }
+
+        /**
+         * cigar()
+         *
+         * @brief
+         * Get the edit script of the match.
+         */
+        const std::string&
+        cigar () const
+        {
+            return this->_cigar;
+        }
+
+        /**
+         * haystack()
+         *
+         * @brief
+         * Get part of the haystack sequence that was matched with the needle.
+         * @return String representation of the match.
+         */
+        std::string
+        haystack ()
+        {
+            this->render ();
+            if (this->_parser)
+            {
+                return this->_parser(this->_haystack);
+            }
+            else
+            {
+                return this->_haystack._sequence.toString () + ' ' +
+                    "from " + std::to_string(this->_haystack._start) + " to "
+                    + std::to_string(this->_haystack._end);
+            }
+        }
+
+        /**
+         * needle()
+         *
+         * @brief
+         * Get part of the needle sequence that was matched with the haystack.
+         * @return String representation of the match.
+         */
+        std::string
+        needle ()
+        {
+            this->render ();
+            if (this->_parser)
+            {
+                return this->_parser(this->_needle);
+            }
+            else
+            {
+                return this->_needle._sequence.toString () + ' ' +
+                    "from " + std::to_string(this->_needle._start) + " to "
+                    + std::to_string(this->_needle._end);
+            }
+        }
+
+        /**
+         * score()
+         *
+         * @brief
+         * Get the calculated score for the match.
+         */
+        std::string
+        score()
+        {
+            std::string res = "Score ";
+            res += std::to_string(this->_score);
+            return res;
+        }
+
+        int _score;
+        Item<Tp> _haystack;
+        Item<Tp> _needle;
+        Strand _strand = Strand::forward;
+        std::string _cigar;
+        std::string (*_parser)(Item<Tp>&);
+
+      private:
+        /**
+         * render()
+         *
+         * @brief
+         * Render the aligned sequences of both items once from the edit script, the haystack
+         * is read modulo its length so matches across the origin of a circular one wrap.
+         */
+        void
+        render ()
+        {
+            if (this->_rendered || !this->_needleSource || !this->_haystackSource)
+                return;
+            this->_rendered = true;
+            const Tp& needleSource = *this->_needleSource;
+            const ReverseComplement<Tp> complement (needleSource);
+            const Tp& haystackSource = this->_haystackSource->sequence;
+            const size_t length = haystackSource.length ();
+            size_t i = this->_needleBegin;
+            size_t j = this->_haystackBegin;
+            size_t count = 0;
+            for (char operation : this->_cigar)
+            {
+                if (operation >= '0' && operation <= '9')
+                {
+                    count = count * 10 + (operation - '0');
+                    continue;
+                }
+                for (; count > 0; --count)
+                {
+                    if (operation == 'D')
+                        this->_needle._sequence += "-";
+                    else if (this->_strand == Strand::reverse)
+                        this->_needle._sequence += complement[i++];
+                    else
+                        this->_needle._sequence += needleSource[i++];
+                    if (operation != 'I')
+                        this->_haystack._sequence += haystackSource[j++ % length];
+                    else
+                        this->_haystack._sequence += "-";
+                }
+            }
+        }
+
+        std::shared_ptr<const Tp> _needleSource;
+        std::shared_ptr<const detail::Haystack<Tp>> _haystackSource;
+        size_t _needleBegin = 0;
+        size_t _haystackBegin = 0;
+        bool _rendered = false;
+    };
+
+    /**
+     * ScorePolicy
+     *
+     * @brief
+     * Scoring scheme fixed at compile time, the score of a match and a mismatch and the
+     * penalties of a gap as constants. It converts to a score matrix, which tabulates
+     * every scheme once for all queries.
+     */
+    template <int Match, int Mismatch, int Gap, int GapOpen = 0>
+    struct ScorePolicy
+    {
+        static constexpr int match = Match;
+        static constexpr int mismatch = Mismatch;
+        static constexpr int gap = Gap;
+        static constexpr int gapOpen = GapOpen;
+    };
+
+    /**
+     * ScoreMatrix
+     *
+     * @brief
+     * Class that describes how fuzzy scores are calculated when comparing two sequence characters.
+     * The scores of all pairs of characters are kept in a table shared by copies of the matrix,
+     * a gap of some length costs the gap opening once and the gap for every character.
+     */
+    class ScoreMatrix
+    {
+      public:
+        ScoreMatrix () = default;
+        ScoreMatrix (const ScoreMatrix& other)
+        {
+            this->_match = other._match;
+            this->_mismatch = other._mismatch;
+            this->_gap = other._gap;
+            this->_gapOpen = other._gapOpen;
+            this->_highest = other._highest;
+            this->_lowest = other._lowest;
+            this->_table = other._table;
+        }
+        ScoreMatrix (int match, int mismatch, int gap, int gapOpen = 0)
+        {
+            this->_match = match;
+            this->_mismatch = mismatch;
+            this->_gap = gap;
+            this->_gapOpen = gapOpen;
+            this->tabulate ([match, mismatch] (char r1, char r2) {
+                return tolower (r1) == tolower (r2) ? match : mismatch;
+            });
+        }
+        template <int Match, int Mismatch, int Gap, int GapOpen>
+        ScoreMatrix (ScorePolicy<Match, Mismatch, Gap, GapOpen>)
+            : ScoreMatrix (ScoreMatrix::tabulated<Match, Mismatch, Gap, GapOpen> ()) {}
+
+        /**
+         * nucleotide()
+         *
+         * @brief
+         * Score matrix for IUPAC nucleotide codes, mismatches between two purines or two
+         * pyrimidines are transitions and all others transversions. Ambiguous codes score the
+         * rounded average over the bases they stand for and N scores the unknown value against
+         * every code, other characters only match themselves.
+         * @param match, transition, transversion The scores of two bases.
+         * @param unknown The score of N against any nucleotide code.
+         * @param gap, gapOpen The penalty of every gap character and of opening a gap.
+         */
+        static ScoreMatrix
+        nucleotide (int match, int transition, int transversion, int unknown, int gap, int gapOpen = 0)
+        {
+            ScoreMatrix scores (match, transversion, gap, gapOpen);
+            auto bases = [] (char code) {
+                switch (tolower (code))
+                {
+                    case 'a': return 1;
+                    case 'c': return 2;
+                    case 'g': return 4;
+                    case 't': case 'u': return 8;
+                    case 'r': return 1 | 4;
+                    case 'y': return 2 | 8;
+                    case 's': return 2 | 4;
+                    case 'w': return 1 | 8;
+                    case 'k': return 4 | 8;
+                    case 'm': return 1 | 2;
+                    case 'b': return 2 | 4 | 8;
+                    case 'd': return 1 | 4 | 8;
+                    case 'h': return 1 | 2 | 8;
+                    case 'v': return 1 | 2 | 4;
+                    case 'n': return 1 | 2 | 4 | 8;
+                    default: return 0;
+                }
+            };
+            scores.tabulate ([&] (char r1, char r2) {
+                int first = bases (r1);
+                int second = bases (r2);
+                if (first == 0 || second == 0)
+                    return tolower (r1) == tolower (r2) ? match : transversion;
+                if (first == 15 || second == 15)
+                    return unknown;
+
+                /* With A, C, G, T as 0 to 3 transitions differ in the second bit only */
+                int sum = 0;
+                int pairs = 0;
+                for (int x = 0; x < 4; ++x)
+                    for (int y = 0; y < 4; ++y)
+                        if ((first >> x & 1) && (second >> y & 1))
+                        {
+                            sum += x == y ? match : (x ^ y) == 2 ? transition : transversion;
+                            ++pairs;
+                        }
+                return (int)std::lround ((double)sum / pairs);
+            });
+            return scores;
+        }
+
+        /**
+         * getScore()
+         *
+         * @brief
+         * Calculate the score for two characters from the haystack and needle.
+         * @param r1 Character from haystack.
+         * @param r2 Character from needle.
+         */
+        int
+        getScore (char r1, char r2) const
+        {
+            return this->row (r2)[(unsigned char)r1];
+        }
+
+        /**
+         * row()
+         *
+         * @brief
+         * The scores of a needle character against every haystack character, so that
+         * scoring a node takes a single load.
+         */
+        const int16_t*
+        row (char needle) const
+        {
+            return this->_table->data () + ((size_t)(unsigned char)needle << 8);
+        }
+
+        int _match;
+        int _mismatch;
+        int _gap;
+        int _gapOpen = 0;
+        int _highest = 0;
+        int _lowest = 0;
+
+      private:
+        /**
+         * tabulated()
+         *
+         * @brief
+         * The score matrix of a scoring scheme fixed at compile time, tabulated on first use.
+         */
+        template <int Match, int Mismatch, int Gap, int GapOpen>
+        static const ScoreMatrix&
+        tabulated ()
+        {
+            static const ScoreMatrix scores (Match, Mismatch, Gap, GapOpen);
+            return scores;
+        }
+
+        /**
+         * tabulate()
+         *
+         * @brief
+         * Fill the table with the scores of every pair of characters.
+         * @param score Callable that scores a haystack and a needle character.
+         */
+        template <typename TScore>
+        void
+        tabulate (TScore&& score)
+        {
+            std::shared_ptr<std::vector<int16_t>> table
+                = std::make_shared<std::vector<int16_t>> (1 << 16);
+            this->_highest = std::numeric_limits<int>::min ();
+            this->_lowest = std::numeric_limits<int>::max ();
+            for (int r2 = 0; r2 < 256; ++r2)
+            {
+                for (int r1 = 0; r1 < 256; ++r1)
+                {
+                    int value = score ((char)r1, (char)r2);
+                    if (value < std::numeric_limits<int16_t>::min ()
+                        || value > std::numeric_limits<int16_t>::max ())
+                        throw std::invalid_argument ("Scores have to fit into 16 bits");
+                    (*table)[r2 << 8 | r1] = (int16_t)value;
+                    this->_highest = std::max (this->_highest, value);
+                    this->_lowest = std::min (this->_lowest, value);
+                }
+            }
+            this->_table = table;
+        }
+
+        std::shared_ptr<const std::vector<int16_t>> _table;
+    };
+
+    /**
+     * Node
+     *
+     * @brief
+     * Class that describes one node unit to span the haystack*needle matrix,
+     * it stores the calculated fuzzy score and position.
+     */
+    class Node
+    {
+      public:
+        Node () : _value (Node::_undefined),
+                  _tracebackI (Node::_undefined),
+                  _tracebackJ (Node::_undefined) {}
+
+        int _value;
+        int _tracebackI;
+        int _tracebackJ;
+        bool _alreadyMatched = false;
+        unsigned char _extends = 0;
+        static const int _undefined = std::numeric_limits<int>::max();
+        static const unsigned char _vertical = 1, _horizontal = 2;
+    };
+
+    namespace detail
+    {
+        /**
+         * KarlinAltschul
+         *
+         * @brief
+         * The Karlin-Altschul statistics of ungapped local alignments with a score matrix
+         * and equally frequent bases A, C, G and T. Between random sequences of lengths m
+         * and n about K*m*n*e^(-lambda*S) matches score at least S, the E-value of S.
+         */
+        class KarlinAltschul
+        {
+          public:
+            explicit KarlinAltschul (const ScoreMatrix& scoreSet)
+            {
+                /* The distribution of the score of one pair of bases */
+                std::map<int, double> pairs;
+                for (char r1 : { 'a', 'c', 'g', 't' })
+                    for (char r2 : { 'a', 'c', 'g', 't' })
+                        pairs[scoreSet.getScore (r1, r2)] += 1.0 / 16;
+                double expected = 0;
+                int divisor = 0;
+                for (const std::pair<const int, double>& entry : pairs)
+                {
+                    expected += entry.first * entry.second;
+                    divisor = std::gcd (divisor, std::abs (entry.first));
+                }
+                if (expected >= 0 || pairs.rbegin ()->first <= 0)
+                    throw std::invalid_argument (
+                        "E-values need positive scores and a negative expected score of the bases");
+
+                /* Lambda is the positive root of the sum of p*e^(lambda*s) minus one */
+                auto moment = [&pairs] (double lambda) {
+                    double sum = 0;
+                    for (const std::pair<const int, double>& entry : pairs)
+                        sum += entry.second * std::exp (lambda * entry.first);
+                    return sum - 1;
+                };
+                double low = 0;
+                double high = 1;
+                while (moment (high) < 0)
+                    high *= 2;
+                for (int step = 0; step < 100; ++step)
+                {
+                    double middle = (low + high) / 2;
+                    (moment (middle) < 0 ? low : high) = middle;
+                }
+                this->_lambda = high;
+                double entropy = 0;
+                for (const std::pair<const int, double>& entry : pairs)
+                    entropy += entry.second * entry.first * std::exp (this->_lambda * entry.first);
+                entropy *= this->_lambda;
+
+                /* The sum over walks of k pairs of the expectation of e^(lambda*S) below
+                 * zero and the probability of S from zero on, divided by k */
+                const int lowest = pairs.begin ()->first / divisor;
+                std::vector<double> walk (1, 1.0);
+                double sum = 0;
+                for (int k = 1; k <= 1000; ++k)
+                {
+                    std::vector<double> next (walk.size () + (pairs.rbegin ()->first
+                        - pairs.begin ()->first) / divisor, 0.0);
+                    for (size_t s = 0; s < walk.size (); ++s)
+                        for (const std::pair<const int, double>& entry : pairs)
+                            next[s + entry.first / divisor - lowest] += walk[s] * entry.second;
+                    walk.swap (next);
+                    double term = 0;
+                    for (size_t s = 0; s < walk.size (); ++s)
+                    {
+                        int score = ((int)s + k * lowest) * divisor;
+                        term += score < 0 ? walk[s] * std::exp (this->_lambda * score) : walk[s];
+                    }
+                    sum += term / k;
+                    if (term / k < 1e-12)
+                        break;
+                }
+                this->_k = this->_lambda * divisor * std::exp (-2 * sum)
+                    / (entropy * (1 - std::exp (-this->_lambda * divisor)));
+            }
+
+            /**
+             * eValue(), score()
+             *
+             * @brief
+             * The E-value of a score, and the lowest score with at most an E-value.
+             * @param space The product of the sequence lengths.
+             */
+            double
+            eValue (int score, double space) const
+            {
+                return this->_k * space * std::exp (-this->_lambda * score);
+            }
+            int
+            score (double eValue, double space) const
+            {
+                return (int)std::ceil (std::log (this->_k * space / eValue) / this->_lambda);
+            }
+
+            double _lambda;
+            double _k;
+        };
+
+        /**
+         * GapScores
+         *
+         * @brief
+         * The best scores of a node that end in a vertical or a horizontal gap, kept next
+         * to the matrix when opening a gap costs more than extending it.
+         */
+        struct GapScores
+        {
+            int _vertical;
+            int _horizontal;
+            static constexpr int _closed = std::numeric_limits<int>::min () / 2;
+        };
+
+        /**
+         * LinearGaps, AffineGaps
+         *
+         * @brief
+         * Gap models of the alignment kernels. A linear gap costs the same for every
+         * character, an affine gap also costs opening it and keeps the best scores ending
+         * in a gap next to the scores of the nodes.
+         */
+        struct LinearGaps
+        {
+            static constexpr bool affine = false;
+        };
+        struct AffineGaps
+        {
+            static constexpr bool affine = true;
+        };
+
+        /**
+         * HybridAlignment, LocalAlignment, GlobalAlignment, SemiGlobalAlignment,
+         * OverlapAlignment
+         *
+         * @brief
+         * Alignment modes of the kernels. Clamped modes never score below zero, so their
+         * matches start and end at any node. The others start in the first row or column
+         * where it is free, the haystack before a match is free along the first row and
+         * the needle before it along the first column, and end in the last row or column
+         * where their mode allows it or else in the last node. The hybrid mode keeps the
+         * ties of its kernels, where equal gaps from above and from the left give way to
+         * the diagonal neighbour, the others take the best neighbour.
+         */
+        struct HybridAlignment
+        {
+            static constexpr bool clamped = true, diagonalTies = true;
+            static constexpr bool freeRow = true, freeColumn = true;
+            static constexpr bool endRow = false, endColumn = false;
+        };
+        struct LocalAlignment
+        {
+            static constexpr bool clamped = true, diagonalTies = false;
+            static constexpr bool freeRow = true, freeColumn = true;
+            static constexpr bool endRow = false, endColumn = false;
+        };
+        struct GlobalAlignment
+        {
+            static constexpr bool clamped = false, diagonalTies = false;
+            static constexpr bool freeRow = false, freeColumn = false;
+            static constexpr bool endRow = false, endColumn = false;
+        };
+        struct SemiGlobalAlignment
+        {
+            static constexpr bool clamped = false, diagonalTies = false;
+            static constexpr bool freeRow = true, freeColumn = false;
+            static constexpr bool endRow = true, endColumn = false;
+        };
+        struct OverlapAlignment
+        {
+            static constexpr bool clamped = false, diagonalTies = false;
+            static constexpr bool freeRow = true, freeColumn = true;
+            static constexpr bool endRow = true, endColumn = true;
+        };
+
+        /**
+         * RowKernel
+         *
+         * @brief
+         * Arguments to fill one row of the haystack*needle matrix with lanes of type T,
+         * scores are clamped to the saturation value so that overflows can be detected.
+         * The profile holds the score of the needle character of the row against every
+         * haystack character.
+         */
+        template <typename T>
+        struct RowKernel
+        {
+            const T* previous;
+            T* current;
+            const T* profile;
+            const uint64_t* matched;
+            T gap;
+            T saturation;
+            int lastJ;
+            bool lastRow;
+        };
+
+        template <typename T>
+        inline bool
+        isMatched (const RowKernel<T>& row, int j)
+        {
+            return (row.matched[j >> 6] >> (j & 63)) & 1;
+        }
+
+        /**
+         * scoreNode()
+         *
+         * @brief
+         * Score one node of a row like FuzzyQuery::step, ties between the upper and left
+         * neighbour resolve to the diagonal one.
+         */
+        template <typename T>
+        inline T
+        scoreNode (const RowKernel<T>& row, int j)
+        {
+            if (isMatched (row, j))
+                return 0;
+            int a = j == row.lastJ ? row.previous[j] : row.previous[j] - row.gap;
+            int b = row.lastRow ? row.current[j - 1] : row.current[j - 1] - row.gap;
+            int c = row.previous[j - 1] + row.profile[j - 1];
+            int value = (a > b && a > c) ? a : (b > c && b > a) ? b : c;
+            return std::min (std::max (value, 0), (int)row.saturation);
+        }
+
+        /**
+         * fillRowScalar()
+         *
+         * @brief
+         * Fill one row node by node, used for the last row where gaps are free and for short rows.
+         * @return The maximum score of the row.
+         */
+        template <typename T>
+        inline T
+        fillRowScalar (const RowKernel<T>& row)
+        {
+            T best = 0;
+            row.current[0] = 0;
+            for (int j = 1; j <= row.lastJ; ++j)
+            {
+                row.current[j] = scoreNode (row, j);
+                best = std::max (best, row.current[j]);
+            }
+            return best;
+        }
+
+        /**
+         * fillRowVector()
+         *
+         * @brief
+         * Fill one row with vectors of Bytes width along the haystack. A vector is first scored
+         * from the row above and then rescored from its left neighbours until no node changes,
+         * since every node only depends on its left neighbour the result is the same as node
+         * by node. Vectors with nodes of earlier matches are scored node by node.
+         * @return The maximum score of the row.
+         */
+        template <typename T, int Bytes>
+        [[gnu::always_inline]] inline T
+        fillRowVector (const RowKernel<T>& row)
+        {
+            typedef T Vector __attribute__ ((vector_size (Bytes)));
+            constexpr int width = Bytes / sizeof (T);
+
+            if (row.lastRow || row.lastJ < 2 * width)
+                return fillRowScalar (row);
+
+            const Vector zero = {};
+            const Vector gap = zero + row.gap;
+            const Vector saturation = zero + row.saturation;
+            const int lastJ = row.lastJ;
+            Vector up, diagonal, profile, left, best = zero;
+
+            row.current[0] = 0;
+            int j = 1;
+            for (; j + width <= lastJ; j += width)
+            {
+                uint64_t matched = row.matched[j >> 6] >> (j & 63);
+                if ((j & 63) + width > 64)
+                    matched |= row.matched[(j >> 6) + 1] << (64 - (j & 63));
+                if (width < 64)
+                    matched &= ((uint64_t)1 << width) - 1;
+                if (matched != 0)
+                {
+                    for (int k = j; k < j + width; ++k)
+                        row.current[k] = scoreNode (row, k);
+                    memcpy (&left, row.current + j, Bytes);
+                    best = best > left ? best : left;
+                    continue;
+                }
+
+                memcpy (&up, row.previous + j, Bytes);
+                memcpy (&diagonal, row.previous + j - 1, Bytes);
+                memcpy (&profile, row.profile + j - 1, Bytes);
+                Vector a = up - gap;
+                Vector c = diagonal + profile;
+                Vector upper = a > c ? a : c;
+                Vector value = upper > zero ? upper : zero;
+                value = value < saturation ? value : saturation;
+
+                /* Ties between the upper and left neighbour resolve to the diagonal one,
+                 * which is the score from above already unless the upper one is greater */
+                for (;;)
+                {
+                    memcpy (row.current + j, &value, Bytes);
+                    memcpy (&left, row.current + j - 1, Bytes);
+                    Vector b = left - gap;
+                    Vector next = b > upper ? b : (b == a ? c : upper);
+                    next = next > zero ? next : zero;
+                    next = next < saturation ? next : saturation;
+                    if (memcmp (&next, &value, Bytes) == 0)
+                        break;
+                    value = next;
+                }
+                best = best > value ? best : value;
+            }
+
+            T result = 0;
+            T lanes[width];
+            memcpy (lanes, &best, Bytes);
+            for (int k = 0; k < width; ++k)
+                result = std::max (result, lanes[k]);
+            for (; j <= lastJ; ++j)
+            {
+                row.current[j] = scoreNode (row, j);
+                result = std::max (result, row.current[j]);
+            }
+            return result;
+        }
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+        template <typename T>
+        __attribute__ ((target ("sse4.1"))) T
+        fillRowSse41 (const RowKernel<T>& row)
+        {
+            return fillRowVector<T, 16> (row);
+        }
+        template <typename T>
+        __attribute__ ((target ("avx2"))) T
+        fillRowAvx2 (const RowKernel<T>& row)
+        {
+            return fillRowVector<T, 32> (row);
+        }
+        template <typename T>
+        __attribute__ ((target ("avx512bw"))) T
+        fillRowAvx512 (const RowKernel<T>& row)
+        {
+            return fillRowVector<T, 64> (row);
+        }
+#elif defined (__GNUC__)
+        template <typename T>
+        T
+        fillRowGeneric (const RowKernel<T>& row)
+        {
+            return fillRowVector<T, 16> (row);
+        }
+#endif
+
+        /**
+         * instructionSet()
+         *
+         * @brief
+         * The widest instruction set supported by the running CPU that has a row kernel.
+         */
+        inline const char*
+        instructionSet ()
+        {
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+            __builtin_cpu_init ();
+            if (__builtin_cpu_supports ("avx512bw"))
+                return "avx512bw";
+            if (__builtin_cpu_supports ("avx2"))
+                return "avx2";
+            if (__builtin_cpu_supports ("sse4.1"))
+                return "sse4.1";
+            return "scalar";
+#elif defined (__GNUC__)
+            return "generic";
+#else
+            return "scalar";
+#endif
+        }
+
+        /**
+         * rowFill()
+         *
+         * @brief
+         * Pick the row kernel for the running CPU once.
+         */
+        template <typename T>
+        T (*rowFill ()) (const RowKernel<T>&)
+        {
+            static T (*const fill) (const RowKernel<T>&) = [] () -> T (*) (const RowKernel<T>&) {
+                std::string name = instructionSet ();
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+                if (name == "avx512bw")
+                    return fillRowAvx512<T>;
+                if (name == "avx2")
+                    return fillRowAvx2<T>;
+                if (name == "sse4.1")
+                    return fillRowSse41<T>;
+#elif defined (__GNUC__)
+                return fillRowGeneric<T>;
+#endif
+                return fillRowScalar<T>;
+            } ();
+            return fill;
+        }
+    }
+
+    /**
+     * Trace
+     *
+     * @brief
+     * The neighbour a node was scored from, none marks nodes where a traceback ends.
+     */
+    enum class Trace : unsigned char
+    {
+        none,
+        up,
+        left,
+        diagonal
+    };
+
+    /**
+     * MemoryMode
+     *
+     * @brief
+     * How much of the haystack*needle matrix a query keeps in memory, the linear mode
+     * only keeps two columns of scores and rebuilds each alignment after it was found,
+     * the compact mode keeps two rows of scores and two bits of trace per node.
+     */
+    enum class MemoryMode
+    {
+        matrix,
+        linear,
+        compact
+    };
+
+    /**
+     * Engine
+     *
+     * @brief
+     * How the scores of the matrix are computed, the vector engine fills whole rows with
+     * saturating 8, 16 or 32 bit lanes of the widest SIMD instruction set of the running CPU
+     * and promotes the lanes when they overflow. The bit-parallel engine does not score the
+     * matrix, it finds the occurrences of the whole needle with the fewest unit cost edits
+     * with Myers' bit vectors, 64 needle characters per machine word.
+     */
+    enum class Engine
+    {
+        scalar,
+        vector,
+        bitParallel
+    };
+
+    /**
+     * AlignmentMode
+     *
+     * @brief
+     * Which parts of the needle and the haystack a match aligns. Hybrid matches are local
+     * alignments whose gaps along the end of the needle and the haystack are free, which
+     * is the default. Local matches align any part of both, global matches the whole needle
+     * with the whole haystack and semi-global matches the whole needle with a part of the
+     * haystack. Overlap matches align a start of one sequence with an end of the other, or
+     * one sequence with a part of the other.
+     */
+    enum class AlignmentMode
+    {
+        hybrid,
+        local,
+        global,
+        semiGlobal,
+        overlap
+    };
+
+    /**
+     * Seeding
+     *
+     * @brief
+     * Class that describes the seeds of a seeded search. The pattern is a spaced seed where
+     * '1' marks bases that have to match and '0' bases that may differ, heavier patterns
+     * and more hits per candidate trade sensitivity for speed.
+     */
+    class Seeding
+    {
+      public:
+        Seeding () = default;
+        Seeding (std::string pattern, int hits, int margin)
+        {
+            this->_pattern = pattern;
+            this->_hits = hits;
+            this->_margin = margin;
+        }
+
+        std::string _pattern;
+        int _hits = 1;
+        int _margin = 16;
+    };
+
+    /**
+     * SeedHit
+     *
+     * @brief
+     * A seed found at the same positions of needle and haystack, positions start at zero.
+     */
+    class SeedHit
+    {
+      public:
+        int _needle;
+        int _haystack;
+    };
+
+    namespace detail
+    {
+        /**
+         * SeedIndex
+         *
+         * @brief
+         * Hashed index of the positions of all spaced seeds of a text, the entries are
+         * grouped by bucket so that a lookup only scans one bucket.
+         */
+        class SeedIndex
+        {
+          public:
+            SeedIndex (const std::string& text, const std::string& pattern)
+                : _pattern (pattern)
+            {
+                for (int k = 0; k < (int)pattern.size (); ++k)
+                    if (pattern[k] != '0')
+                        this->_care.push_back (k);
+                if (this->_care.empty () || this->_care.size () > 32)
+                    throw std::invalid_argument ("Seed patterns need between 1 and 32 bases to match");
+
+                int bits = 4;
+                while (((size_t)1 << bits) < text.size () && bits < 30)
+                    ++bits;
+                this->_shift = 64 - bits;
+                this->_offsets.assign (((size_t)1 << bits) + 1, 0);
+
+                std::vector<std::pair<uint64_t, uint32_t>> seeds;
+                for (size_t j = 0; j + pattern.size () <= text.size (); ++j)
+                {
+                    uint64_t key;
+                    if (this->key (text.data () + j, key))
+                    {
+                        seeds.emplace_back (key, (uint32_t)j);
+                        ++this->_offsets[this->bucket (key) + 1];
+                    }
+                }
+                for (size_t b = 1; b < this->_offsets.size (); ++b)
+                    this->_offsets[b] += this->_offsets[b - 1];
+                this->_entries.resize (seeds.size ());
+                std::vector<uint32_t> fill (this->_offsets.begin (), this->_offsets.end () - 1);
+                for (const std::pair<uint64_t, uint32_t>& seed : seeds)
+                    this->_entries[fill[this->bucket (seed.first)]++] = seed;
+            }
+
+            /**
+             * key()
+             *
+             * @brief
+             * Pack the bases under the pattern with two bits each.
+             * @return Whether all of them are A, C, G or T.
+             */
+            bool
+            key (const char* text, uint64_t& key) const
+            {
+                key = 0;
+                for (int k : this->_care)
+                {
+                    uint64_t code;
+                    switch (tolower (text[k]))
+                    {
+                        case 'a': code = 0; break;
+                        case 'c': code = 1; break;
+                        case 'g': code = 2; break;
+                        case 't': code = 3; break;
+                        default: return false;
+                    }
+                    key = (key << 2) | code;
+                }
+                return true;
+            }
+
+            /**
+             * find()
+             *
+             * @brief
+             * Visit every text position with the given key.
+             */
+            template <typename TVisit>
+            void
+            find (uint64_t key, TVisit&& visit) const
+            {
+                size_t b = this->bucket (key);
+                for (uint32_t e = this->_offsets[b]; e < this->_offsets[b + 1]; ++e)
+                    if (this->_entries[e].first == key)
+                        visit ((int)this->_entries[e].second);
+            }
+
+            std::string _pattern;
+
+          private:
+            size_t
+            bucket (uint64_t key) const
+            {
+                return (key * 0x9E3779B97F4A7C15ull) >> this->_shift;
+            }
+
+            std::vector<int> _care;
+            int _shift;
+            std::vector<uint32_t> _offsets;
+            std::vector<std::pair<uint64_t, uint32_t>> _entries;
+        };
+
+        /**
+         * BitPattern
+         *
+         * @brief
+         * Needle encoded for Myers' bit-vector edit distance, every block of 64 needle
+         * characters keeps one mask per character with the bits of the rows it matches.
+         */
+        class BitPattern
+        {
+          public:
+            BitPattern (const std::string& needle)
+                : _length (needle.size ()), _blocks ((needle.size () + 63) / 64)
+            {
+                this->_masks.assign (256 * this->_blocks, 0);
+                for (size_t i = 0; i < needle.size (); ++i)
+                    this->_masks[(unsigned char)needle[i] * this->_blocks + i / 64]
+                        |= (uint64_t)1 << (i % 64);
+            }
+
+            /**
+             * scan()
+             *
+             * @brief
+             * Compute the unit cost edit distance of the whole needle to the closest part of
+             * the text ending at every position. The columns of the distance matrix are kept
+             * as vertical deltas in two words per block, blocks pass the horizontal delta of
+             * their last row down to the next block.
+             * @param text The text to be searched.
+             * @param visit Callable that receives every end position, counted from one, and
+             * the distance of the needle to the text ending there.
+             */
+            template <typename TVisit>
+            void
+            scan (std::string_view text, TVisit&& visit) const
+            {
+                /* The last block follows the row of the last needle character instead of
+                 * its last bit, the rows below it are never read */
+                const size_t blocks = this->_blocks;
+                const int last = (this->_length - 1) % 64;
+                int distance = this->_length;
+                if (blocks == 1)
+                {
+                    uint64_t positive = ~(uint64_t)0;
+                    uint64_t negative = 0;
+                    const uint64_t* masks = this->_masks.data ();
+                    for (size_t j = 0; j < text.size (); ++j)
+                    {
+                        distance += BitPattern::advance (positive, negative,
+                            masks[(unsigned char)text[j]], 0, last);
+                        visit ((int)j + 1, distance);
+                    }
+                    return;
+                }
+
+                std::vector<uint64_t> positive (blocks, ~(uint64_t)0), negative (blocks, 0);
+                for (size_t j = 0; j < text.size (); ++j)
+                {
+                    const uint64_t* masks = this->_masks.data () + (unsigned char)text[j] * blocks;
+                    int carry = 0;
+                    for (size_t b = 0; b + 1 < blocks; ++b)
+                        carry = BitPattern::advance (positive[b], negative[b], masks[b], carry, 63);
+                    distance += BitPattern::advance (positive[blocks - 1], negative[blocks - 1],
+                        masks[blocks - 1], carry, last);
+                    visit ((int)j + 1, distance);
+                }
+            }
+
+          private:
+            /**
+             * advance()
+             *
+             * @brief
+             * Advance the vertical deltas of one block by one column.
+             * @param positive, negative The rows whose distance is one more or one less than
+             * the distance of the row above.
+             * @param equal The rows whose needle character equals the text character.
+             * @param carry The horizontal delta of the row above the block.
+             * @param row The bit of the row whose horizontal delta is returned.
+             * @return The horizontal delta of the row.
+             */
+            static inline int
+            advance (uint64_t& positive, uint64_t& negative, uint64_t equal, int carry, int row)
+            {
+                const uint64_t carryNegative = carry < 0;
+                const uint64_t vertical = equal | negative;
+                equal |= carryNegative;
+                const uint64_t horizontal = (((equal & positive) + positive) ^ positive) | equal;
+                uint64_t horizontalPositive = negative | ~(horizontal | positive);
+                uint64_t horizontalNegative = positive & horizontal;
+                int out = (int)((horizontalPositive >> row) & 1) - (int)((horizontalNegative >> row) & 1);
+                horizontalPositive = (horizontalPositive << 1) | (uint64_t)(carry > 0);
+                horizontalNegative = (horizontalNegative << 1) | carryNegative;
+                positive = horizontalNegative | ~(vertical | horizontalPositive);
+                negative = horizontalPositive & vertical;
+                return out;
+            }
+
+            size_t _length;
+            size_t _blocks;
+            std::vector<uint64_t> _masks;
+        };
+
+        /**
+         * Haystack
+         *
+         * @brief
+         * The haystack of a query with its characters lowered once for scoring, shared by
+         * all queries of a batch. A circular haystack repeats its first characters after
+         * its end so that matches can run across the origin.
+         */
+        template <typename Tp>
+        struct Haystack
+        {
+            Haystack (Tp haystackSequence, size_t wrap = 0)
+                : sequence (std::move (haystackSequence))
+            {
+                this->characters.resize (this->sequence.length ());
+                for (size_t j = 0; j < this->characters.size (); ++j)
+                    this->characters[j] = tolower ((char)this->sequence[j]);
+                this->characters.append (this->characters.substr (0, wrap));
+            }
+
+            /**
+             * wrapping()
+             *
+             * @brief
+             * The amount of characters a circular haystack repeats for a needle, the needle
+             * and a band of edits across the origin but never more than the haystack.
+             * @param length, needle The length of the haystack and of the needle.
+             * @param edits The allowed edits, as many as the needle has characters when negative.
+             */
+            static size_t
+            wrapping (size_t length, size_t needle, int edits)
+            {
+                return std::min (length, needle + (edits >= 0 ? (size_t)edits : needle));
+            }
+
+            /**
+             * seedIndex()
+             *
+             * @brief
+             * The seed index of the haystack for a pattern, built once and shared by all
+             * queries on the haystack.
+             */
+            const SeedIndex&
+            seedIndex (const std::string& pattern) const
+            {
+                std::lock_guard<std::mutex> guard (this->lock);
+                for (const std::unique_ptr<SeedIndex>& index : this->indices)
+                    if (index->_pattern == pattern)
+                        return *index;
+                this->indices.emplace_back (new SeedIndex (this->characters, pattern));
+                return *this->indices.back ();
+            }
+
+            Tp sequence;
+            std::string characters;
+            mutable std::mutex lock;
+            mutable std::vector<std::unique_ptr<SeedIndex>> indices;
+        };
+    }
+
+    /**
+     * QueryStats
+     *
+     * @brief
+     * Where a query spent its time and memory during its last search, recorded only when
+     * the library is built with SQN_STATS. Without it the members stay zero and nothing
+     * is recorded on the hot paths.
+     */
+    class QueryStats
+    {
+      public:
+        enum Phase
+        {
+            initialize,
+            update,
+            scan,
+            traceback,
+            phases
+        };
+
+#if defined (SQN_STATS)
+        static constexpr bool enabled = true;
+#else
+        static constexpr bool enabled = false;
+#endif
+
+        /* Nanoseconds spent spanning buffers, scoring nodes, selecting the end node of the
+         * next match and following its traces */
+        uint64_t _nanoseconds[phases] = {};
+        uint64_t _cellsComputed = 0;
+        uint64_t _cellsSkipped = 0;
+        uint64_t _tracebacks = 0;
+        uint64_t _tracebackLength = 0;
+        uint64_t _allocations = 0;
+        uint64_t _allocatedBytes = 0;
+
+        /**
+         * grew()
+         *
+         * @brief
+         * Count a buffer of the query that had to grow.
+         * @param capacity The capacity of the buffer before.
+         * @param buffer The buffer.
+         */
+        template <typename T>
+        void
+        grew (size_t capacity, const std::vector<T>& buffer)
+        {
+            if (buffer.capacity () > capacity)
+            {
+                ++this->_allocations;
+                this->_allocatedBytes += (buffer.capacity () - capacity) * sizeof (T);
+            }
+        }
+
+        QueryStats&
+        operator+= (const QueryStats& other)
+        {
+            for (int phase = 0; phase < phases; ++phase)
+                this->_nanoseconds[phase] += other._nanoseconds[phase];
+            this->_cellsComputed += other._cellsComputed;
+            this->_cellsSkipped += other._cellsSkipped;
+            this->_tracebacks += other._tracebacks;
+            this->_tracebackLength += other._tracebackLength;
+            this->_allocations += other._allocations;
+            this->_allocatedBytes += other._allocatedBytes;
+            return *this;
+        }
+    };
+
+    namespace detail
+    {
+        /**
+         * PhaseTimer
+         *
+         * @brief
+         * Adds the time until the end of its scope to a phase of the stats, an empty object
+         * unless the library is built with SQN_STATS.
+         */
+        class PhaseTimer
+        {
+          public:
+#if defined (SQN_STATS)
+            PhaseTimer (QueryStats& stats, QueryStats::Phase phase)
+                : _stats (stats), _phase (phase), _start (std::chrono::steady_clock::now ()) {}
+            ~PhaseTimer ()
+            {
+                this->_stats._nanoseconds[this->_phase] += std::chrono::duration_cast<
+                    std::chrono::nanoseconds> (std::chrono::steady_clock::now () - this->_start).count ();
+            }
+
+          private:
+            QueryStats& _stats;
+            QueryStats::Phase _phase;
+            std::chrono::steady_clock::time_point _start;
+#else
+            PhaseTimer (QueryStats&, QueryStats::Phase) {}
+#endif
+        };
+    }
+
+    /**
+     * allMatches
+     *
+     * @brief
+     * The amount of matches that asks a query for every match reaching its minimum score,
+     * found in one fill of the matrix instead of one fill per match.
+     */
+    constexpr int allMatches = std::numeric_limits<int>::max ();
+
+    template <typename Tp>
+    class FuzzyBatchQuery;
+
+    /**
+     * FuzzyQuery
+     *
+     * @brief
+     * Class template fuzzy search algorithm calculates a fuzzy score for all nodes in matrix
+     * and returns matching parts of the haystack sequence according to their score.
+     */
+    template <typename Tp>
+    class FuzzyQuery
+    {
+      friend class FuzzyBatchQuery<Tp>;
+
+      public:
+        FuzzyQuery(Tp haystackSequence, Tp needleSequence)
+            : FuzzyQuery (std::make_shared<const detail::Haystack<Tp>> (
+                              std::move (haystackSequence)), std::move (needleSequence)) {}
+
+        /**
+         * setItemParser()
+         *
+         * @brief
+         * Set parser for a single item from a match.
+         * @param parser The function used for parsing part of a sequence with start and end.
+         */
+        void
+        setItemParser(std::string (*parser)(Item<Tp>&))
+        {
+            this->_parser = parser;
+        }
+
+        /**
+         * setMemoryMode()
+         *
+         * @brief
+         * Choose between keeping the complete matrix, the linear and the compact memory
+         * mode, all of them report the same matches. The linear memory mode rebuilds the
+         * traces of long matches in a number of sweeps that grows with the log of their
+         * length.
+         * @param mode The memory mode used by search.
+         */
+        void
+        setMemoryMode (MemoryMode mode)
+        {
+            this->_memoryMode = mode;
+        }
+
+        /**
+         * setEngine()
+         *
+         * @brief
+         * Choose how the scores of the matrix are computed, the scalar and vector engines
+         * report the same matches. The vector engine applies to the matrix memory mode, the
+         * bit-parallel engine needs no matrix and ranks matches by edits instead of scores.
+         * @param engine The engine used by search.
+         */
+        void
+        setEngine (Engine engine)
+        {
+            this->_engine = engine;
+        }
+
+        /**
+         * setAlignmentMode()
+         *
+         * @brief
+         * Choose which parts of the needle and the haystack a match aligns. Modes other than
+         * hybrid are searched in one fill of the matrix by a kernel generated for the mode
+         * and report up to the amount of matches that do not overlap in the haystack. They
+         * need the scalar or vector engine and a memory mode other than linear, global and
+         * overlap matches also need a haystack that is neither circular nor seeded.
+         * @param mode The alignment mode used by search.
+         */
+        void
+        setAlignmentMode (AlignmentMode mode)
+        {
+            this->_alignmentMode = mode;
+        }
+
+        /**
+         * setSeeding()
+         *
+         * @brief
+         * Only align the needle in windows of the haystack around diagonals with enough
+         * spaced seed hits, matches outside of the windows are not found. An empty pattern
+         * searches the whole haystack again.
+         * @param seeding The seed pattern, hits per window and margin around the seeds.
+         */
+        void
+        setSeeding (Seeding seeding)
+        {
+            this->_seeding = seeding;
+        }
+
+        /**
+         * setMinimumScore()
+         *
+         * @brief
+         * Only report matches that score at least the given value. Nodes that cannot reach
+         * it any more, even if all remaining needle characters matched, are not scored
+         * (Ukkonen cut-off), so the scalar engine only scores a band around promising
+         * alignments. Zero reports every match with a positive score.
+         * @param score The minimum score of a match.
+         */
+        void
+        setMinimumScore (int score)
+        {
+            this->_minimumScore = score;
+        }
+
+        /**
+         * setMaxEdits()
+         *
+         * @brief
+         * Only report matches within the given amount of mismatches and gaps of the whole
+         * needle, the edits are translated into the lowest score such a match can have.
+         * @param edits The amount of edits, a negative amount allows any amount.
+         */
+        void
+        setMaxEdits (int edits)
+        {
+            this->_maxEdits = edits;
+        }
+
+        /**
+         * setMaximumEValue(), eValue()
+         *
+         * @brief
+         * Only report matches with at most the given E-value, the amount of matches with
+         * at least their score expected by chance between random sequences of the lengths
+         * of the needle and all searched strands of the haystack. The E-value is translated
+         * into the lowest score such a match can have with the Karlin-Altschul statistics of
+         * the score matrix, which needs a negative expected score of two random bases.
+         * @param eValue The maximum E-value, zero allows any E-value.
+         * @param score The score of a match.
+         */
+        void
+        setMaximumEValue (double eValue)
+        {
+            this->_maximumEValue = eValue;
+        }
+        double
+        eValue (int score) const
+        {
+            return detail::KarlinAltschul (this->_scoreSet).eValue (score, this->space ());
+        }
+
+        /**
+         * setStrand()
+         *
+         * @brief
+         * Search the forward strand, the reverse strand or both strands of the haystack.
+         * The reverse strand is searched with a copy of the reverse complement of the needle
+         * on the same haystack, so the haystack is prepared once and never copied. Both
+         * strands take one pass over the haystack each. Matches of both strands are ordered
+         * by score, the forward strand first on equal scores, and a match is dropped when it
+         * overlaps a better one of the other strand, such as the second strand of a
+         * palindromic site.
+         * @param strand The strands searched.
+         */
+        void
+        setStrand (Strand strand)
+        {
+            this->_strand = strand;
+        }
+
+        /**
+         * setCircular()
+         *
+         * @brief
+         * Treat the haystack as circular like a plasmid, matches may run across the origin.
+         * Only the needle length and a band of the allowed edits are repeated after the end
+         * of the haystack, positions of matches are reported modulo the haystack length so
+         * a match across the origin starts behind its end.
+         * @param circular Whether the haystack is circular.
+         */
+        void
+        setCircular (bool circular)
+        {
+            this->_circular = circular;
+            this->_spanned = false;
+        }
+
+        /**
+         * seeds()
+         *
+         * @brief
+         * Get the seeds that led to every match of a seeded search, in the order of the matches.
+         */
+        std::vector<std::vector<SeedHit>>&
+        seeds ()
+        {
+            return this->_seeds;
+        }
+
+        /**
+         * stats(), setStatsHook()
+         *
+         * @brief
+         * Get the stats of the last search, and set a function that receives them at the
+         * end of every search, for example to export them as metrics. Both are only filled
+         * when the library is built with SQN_STATS.
+         * @param hook The function called with the stats.
+         */
+        const QueryStats&
+        stats () const
+        {
+            return this->_stats;
+        }
+        void
+        setStatsHook (std::function<void (const QueryStats&)> hook)
+        {
+            this->_statsHook = std::move (hook);
+        }
+
+        /**
+         * setThreads()
+         *
+         * @brief
+         * Set the amount of threads filling the matrix, tiles of the matrix are scored in
+         * wavefronts along its anti-diagonals so that every tile only waits for the tiles
+         * above and left of it. The matches are the same for any amount of threads.
+         * @param threads The amount of threads, zero uses all hardware threads.
+         */
+        void
+        setThreads (unsigned threads)
+        {
+            this->_threads = threads != 0 ? threads
+                : std::max (1u, std::thread::hardware_concurrency ());
+        }
+
+        /**
+         * initializeScoreMatrix()
+         *
+         * @brief
+         * Set rewards and penalties for score calculation as well as amounts.
+         * @param scoreSet The values used to calculate scores for sequence parts.
+         * @param amount The amount of matches to be retrieved, allMatches retrieves every
+         * match that reaches the minimum score in a single search of the haystack.
+         */
+        void
+        initializeScoreMatrix (ScoreMatrix scoreSet, int amount)
+        {
+            this->_scoreSet = scoreSet;
+            this->_amount = amount;
+            this->_spanned = false;
+        }
+
+        /**
+         * initializeMatrix()
+         *
+         * @brief
+         * Set the sequences of the query, the matrix of haystack*needle dimensions
+         * is spanned on the first search that needs it.
+         * @param haystackSequence The complete genome to be searched.
+         * @param needleSequence The needle sequence to be approximately searched.
+         */
+        void
+        initializeMatrix (Tp haystackSequence, Tp needleSequence)
+        {
+            this->initializeMatrix (std::make_shared<const detail::Haystack<Tp>> (
+                std::move (haystackSequence)), std::move (needleSequence));
+        }
+
+        /**
+         * updateMatrix()
+         *
+         * @brief
+         * Update all nodes in the matrix.
+         */
+        void
+        updateMatrix ()
+        {
+            if (!this->_spanned)
+                this->spanMatrix ();
+
+            detail::PhaseTimer timer (this->_stats, QueryStats::update);
+            const int lastI = this->_nodes.size () - 1;
+            const int lastJ = this->_nodes[0].size () - 1;
+            if constexpr (QueryStats::enabled)
+                this->_stats._cellsComputed += (uint64_t)lastI * lastJ;
+
+            if (this->_threads > 1 && (int64_t)lastI * lastJ >= (1 << 16))
+            {
+                this->updateWavefront (lastI, lastJ);
+            }
+            else
+            {
+                for (int i = 1; i <= lastI; i++)
+                    this->updateRow (i, 1, lastJ, lastI, lastJ);
+            }
+
+            this->_score = this->_nodes[lastI][lastJ]._value;
+        }
+
+        /**
+         * search()
+         *
+         * @brief
+         * Get aligned haystack sequence and needle sequence matches according to amount.
+         */
+        std::list<Match<Tp>>&
+        search ()
+        {
+            this->_stats = QueryStats ();
+            this->_significantScore = this->_maximumEValue > 0 ? detail::KarlinAltschul (
+                this->_scoreSet).score (this->_maximumEValue, this->space ()) : 0;
+            if (this->_circular && this->_haystack->characters.size () < (size_t)this->columns ())
+            {
+                detail::PhaseTimer timer (this->_stats, QueryStats::initialize);
+                this->_haystack = std::make_shared<const detail::Haystack<Tp>> (
+                    this->_haystack->sequence, this->wrap ());
+            }
+            if (this->_alignmentMode != AlignmentMode::hybrid)
+            {
+                if (this->_engine == Engine::bitParallel || this->_memoryMode == MemoryMode::linear)
+                    throw std::invalid_argument ("Alignment modes need the scalar or vector engine "
+                        "and a memory mode other than linear");
+                if ((this->_circular || !this->_seeding._pattern.empty ())
+                    && (this->_alignmentMode == AlignmentMode::global
+                        || this->_alignmentMode == AlignmentMode::overlap))
+                    throw std::invalid_argument (
+                        "Global and overlap alignments need the whole haystack without seeding");
+            }
+            if (this->_strand != Strand::forward)
+                this->searchStrands ();
+            else if (!this->_seeding._pattern.empty ())
+                this->searchSeeded ();
+            else if (this->_engine == Engine::bitParallel)
+                this->searchBitParallel ();
+            else if (this->_alignmentMode != AlignmentMode::hybrid)
+                this->searchAligned ();
+            else if (this->_amount == allMatches)
+                this->searchThreshold ();
+            else if (this->_memoryMode == MemoryMode::linear && this->_scoreSet._gapOpen != 0)
+                throw std::invalid_argument ("Affine gaps need the matrix memory mode");
+            else if (this->_memoryMode == MemoryMode::linear)
+                this->searchLinear ();
+            else if (this->_memoryMode == MemoryMode::compact)
+                this->searchCompact ();
+            else if (this->_engine == Engine::vector && this->_scoreSet._gapOpen == 0)
+                this->searchVector ();
+            else
+                this->searchMatrix ();
+
+            if constexpr (QueryStats::enabled)
+                if (this->_statsHook)
+                    this->_statsHook (this->_stats);
+            return this->_matches;
+        }
+
+        private:
+          FuzzyQuery(std::shared_ptr<const detail::Haystack<Tp>> haystack, Tp needleSequence)
+          {
+              this->initializeMatrix(haystack, std::move (needleSequence));
+              this->_parser = nullptr;
+              this->_memoryMode = MemoryMode::matrix;
+              this->_engine = Engine::scalar;
+              this->_alignmentMode = AlignmentMode::hybrid;
+              this->_threads = 1;
+              this->_minimumScore = 0;
+              this->_maxEdits = -1;
+              this->_maximumEValue = 0;
+              this->_significantScore = 0;
+              this->_strand = Strand::forward;
+              this->_circular = false;
+              this->_reverse = false;
+          }
+
+          /**
+           * initializeMatrix()
+           *
+           * @brief
+           * Set the needle of the query and a haystack that may be shared with other queries,
+           * the nodes of an earlier matrix are reused when it is spanned again.
+           * @param haystack The complete genome to be searched.
+           * @param needleSequence The needle sequence to be approximately searched.
+           */
+          void
+          initializeMatrix (std::shared_ptr<const detail::Haystack<Tp>> haystack, Tp needleSequence)
+          {
+              this->_haystack = haystack;
+              this->_needleSequence = std::move (needleSequence);
+              this->_needleSource.reset ();
+              this->_score = 0;
+              this->_spanned = false;
+              this->_matched.clear ();
+              this->_scores.clear ();
+              this->_matchedBits.clear ();
+              this->_directions.clear ();
+              this->_extensions.clear ();
+              this->_laneBytes = 1;
+          }
+
+          /**
+           * searchMatrix()
+           *
+           * @brief
+           * Search with the complete matrix of nodes, the first match fills the matrix and
+           * every further match only rescores the nodes its traceback changed.
+           */
+          std::list<Match<Tp>>&
+          searchMatrix ()
+          {
+              std::vector<std::pair<int, int>> path;
+              int hitCount = 0;
+              while (hitCount < this->_amount)
+              {
+                  if (hitCount == 0 && this->threshold () > 0 && this->_threads == 1
+                      && this->_scoreSet._gapOpen == 0)
+                  {
+                      this->updateBanded ();
+                  }
+                  else if (hitCount == 0)
+                  {
+                      this->updateMatrix ();
+                      this->collectCandidates ();
+                  }
+                  else
+                  {
+                      this->updateRegion (path);
+                  }
+                  int maxNodeValue = 0;
+                  int maxNodeI = Node::_undefined;
+                  int maxNodeJ = Node::_undefined;
+
+                  /* Candidates are ordered by score and then by row and column, entries
+                   * whose node was rescored since are dropped on the way. */
+                  const int64_t width = this->_nodes[0].size ();
+                  {
+                      detail::PhaseTimer timer (this->_stats, QueryStats::scan);
+                      while (!this->_candidates.empty ())
+                      {
+                          std::pair<int, int64_t> top = this->_candidates.front ();
+                          int i = -top.second / width;
+                          int j = -top.second % width;
+                          if (this->_nodes[i][j]._value == top.first)
+                          {
+                              maxNodeValue = top.first;
+                              maxNodeI = i;
+                              maxNodeJ = j;
+                              break;
+                          }
+                          std::pop_heap (this->_candidates.begin (), this->_candidates.end ());
+                          this->_candidates.pop_back ();
+                      }
+                  }
+
+                  if (maxNodeValue == 0 || maxNodeValue < this->threshold ())
+                  {
+                      break;
+                  }
+
+                  /* A gap that extends the gap of its neighbour continues there */
+                  Trace gap = Trace::none;
+                  auto trace = [this, &gap] (int i, int j) {
+                      const Node& node = this->_nodes[i][j];
+                      Trace next;
+                      if (gap != Trace::none)
+                          next = gap;
+                      else if (node._tracebackI == Node::_undefined)
+                          return Trace::none;
+                      else if (node._tracebackI == i)
+                          next = Trace::left;
+                      else
+                          next = node._tracebackJ == j ? Trace::up : Trace::diagonal;
+                      bool extends = (next == Trace::up && (node._extends & Node::_vertical))
+                          || (next == Trace::left && (node._extends & Node::_horizontal));
+                      gap = extends ? next : Trace::none;
+                      return next;
+                  };
+                  path.clear ();
+                  auto mask = [this, &path] (int i, int j) {
+                      for (int column : { j, this->twin (j) })
+                      {
+                          if (column == Node::_undefined)
+                              continue;
+                          this->_nodes[i][column]._value = 0;
+                          this->_nodes[i][column]._alreadyMatched = true;
+                          path.emplace_back (i, column);
+                      }
+                  };
+                  std::pair<int, int> terminal
+                      = this->traceback (maxNodeI, maxNodeJ, maxNodeValue, trace, mask);
+
+                  /* The end node takes over the node the traceback ended on, so it stays
+                   * unmasked and is scored again by the next update. */
+                  this->_nodes[maxNodeI][maxNodeJ]
+                      = this->_nodes[terminal.first][terminal.second];
+                  hitCount++;
+              }
+              return this->_matches;
+          }
+
+          /**
+           * spanMatrix()
+           *
+           * @brief
+           * Span the matrix of haystack*needle dimensions and set undefined states,
+           * nodes that are never scored keep a score of zero.
+           */
+          void
+          spanMatrix ()
+          {
+              detail::PhaseTimer timer (this->_stats, QueryStats::initialize);
+              std::vector<std::vector<Node>>& nodes = this->_nodes;
+              Node unscored;
+              unscored._value = 0;
+              nodes.resize (this->_needleSequence.length () + 1);
+              for (std::vector<Node>& row : nodes)
+              {
+                  size_t capacity = row.capacity ();
+                  row.assign (this->columns () + 1, unscored);
+                  if constexpr (QueryStats::enabled)
+                      this->_stats.grew (capacity, row);
+              }
+
+              nodes[0][0]._value = 0;
+
+              if (this->_scoreSet._gapOpen != 0)
+              {
+                  this->_gaps.resize (nodes.size ());
+                  for (std::vector<detail::GapScores>& row : this->_gaps)
+                  {
+                      size_t capacity = row.capacity ();
+                      row.assign (nodes[0].size (),
+                          { detail::GapScores::_closed, detail::GapScores::_closed });
+                      if constexpr (QueryStats::enabled)
+                          this->_stats.grew (capacity, row);
+                  }
+              }
+
+              for (int i = 1; i < nodes.size (); i++)
+              {
+                  nodes[i][0]._value = nodes[i - 1][0]._value;
+                  nodes[i][0]._tracebackI = i - 1;
+                  nodes[i][0]._tracebackJ = 0;
+              }
+
+              for (int j = 1; j < nodes[0].size (); j++)
+              {
+                  nodes[0][j]._value = nodes[0][j - 1]._value;
+                  nodes[0][j]._tracebackI = 0;
+                  nodes[0][j]._tracebackJ = j - 1;
+              }
+              this->_spanned = true;
+          }
+
+          /**
+           * kernel()
+           *
+           * @brief
+           * Call a kernel with the gap model of the query and whether it scores the last row
+           * as compile time constants, so that every combination is generated on its own and
+           * its loops do not branch on them for every node.
+           * @param lastRow Whether the kernel scores the last row.
+           * @param kernel Callable taking the gap model and a std::bool_constant of the row.
+           */
+          template <typename TKernel>
+          inline void
+          kernel (bool lastRow, TKernel&& kernel)
+          {
+              auto row = [lastRow, &kernel] (auto gaps) {
+                  if (lastRow)
+                      kernel (gaps, std::true_type ());
+                  else
+                      kernel (gaps, std::false_type ());
+              };
+              if (this->_scoreSet._gapOpen != 0)
+                  row (detail::AffineGaps ());
+              else
+                  row (detail::LinearGaps ());
+          }
+
+          /**
+           * cell()
+           *
+           * @brief
+           * Score one node from its neighbours with an alignment mode and a gap model, gaps
+           * along the last row and column are free when they are flagged, as the hybrid mode
+           * does. Kernels score the last column apart, so neither position is compared for
+           * every node.
+           * @param up, left, diagonal The scores of the neighbours.
+           * @param substitution The score of the characters compared by the node.
+           * @param vertical, horizontal The best scores ending in a gap of the upper and the
+           * left neighbour, replaced by those of the node. Only affine gaps use them.
+           * @param extends Receives which gaps of the node extend those of its neighbours.
+           * @param trace Receives the neighbour the node was scored from.
+           * @return The score of the node.
+           */
+          template <typename TMode, typename TGaps, bool LastRow, bool LastColumn>
+          inline int
+          cell (int up, int left, int diagonal, int substitution,
+                int& vertical, int& horizontal, unsigned char& extends, Trace& trace)
+          {
+              const int extend = this->_scoreSet._gap;
+              if constexpr (!TGaps::affine)
+              {
+                  return this->choose<TMode> (LastColumn ? up : up - extend,
+                      LastRow ? left : left - extend, diagonal + substitution, trace);
+              }
+              else
+              {
+                  /* Gotoh: a gap either extends the gap of the neighbour or opens a new one
+                   * from its score */
+                  const int open = this->_scoreSet._gapOpen + extend;
+                  int extended = LastColumn ? vertical : vertical - extend;
+                  int opened = LastColumn ? up : up - open;
+                  vertical = std::max (extended, opened);
+                  extends = extended > opened ? Node::_vertical : 0;
+                  extended = LastRow ? horizontal : horizontal - extend;
+                  opened = LastRow ? left : left - open;
+                  horizontal = std::max (extended, opened);
+                  extends |= extended > opened ? Node::_horizontal : 0;
+                  return this->choose<TMode> (vertical, horizontal, diagonal + substitution, trace);
+              }
+          }
+
+          /**
+           * scoreNode()
+           *
+           * @brief
+           * Score one node of the matrix from its neighbours and set its traceback, gaps do
+           * not pass nodes of earlier matches. The runtime overload finds the kernel of the
+           * node for loops that skip between columns.
+           * @param i, j The node to be scored.
+           * @param scores The scores of the needle character of the row.
+           * @param lastI, lastJ The last row and column of the matrix.
+           * @return Whether the score of the node, or of a gap through it, changed.
+           */
+          template <typename TGaps, bool LastRow, bool LastColumn>
+          inline bool
+          scoreNode (int i, int j, const int16_t* scores)
+          {
+              Trace trace;
+              Node& node = this->_nodes[i][j];
+              int before = node._value;
+              int substitution = scores[(unsigned char)this->_haystack->characters[j - 1]];
+              bool gapChanged = false;
+              if constexpr (!TGaps::affine)
+              {
+                  int vertical, horizontal;
+                  node._value = node._alreadyMatched ? this->choose (0, 0, 0, trace)
+                      : this->cell<detail::HybridAlignment, TGaps, LastRow, LastColumn> (
+                          this->_nodes[i - 1][j]._value, this->_nodes[i][j - 1]._value,
+                          this->_nodes[i - 1][j - 1]._value, substitution, vertical, horizontal,
+                          node._extends, trace);
+              }
+              else
+              {
+                  detail::GapScores& gaps = this->_gaps[i][j];
+                  const detail::GapScores previous = gaps;
+                  node._extends = 0;
+                  if (node._alreadyMatched)
+                  {
+                      gaps = { detail::GapScores::_closed, detail::GapScores::_closed };
+                      node._value = this->choose (0, 0, 0, trace);
+                  }
+                  else
+                  {
+                      gaps._vertical = this->_gaps[i - 1][j]._vertical;
+                      gaps._horizontal = this->_gaps[i][j - 1]._horizontal;
+                      node._value = this->cell<detail::HybridAlignment, TGaps, LastRow, LastColumn> (
+                          this->_nodes[i - 1][j]._value, this->_nodes[i][j - 1]._value,
+                          this->_nodes[i - 1][j - 1]._value, substitution, gaps._vertical,
+                          gaps._horizontal, node._extends, trace);
+                  }
+                  gapChanged = gaps._vertical != previous._vertical
+                      || gaps._horizontal != previous._horizontal;
+              }
+              node._tracebackI = trace == Trace::none ? Node::_undefined
+                  : trace == Trace::left ? i : i - 1;
+              node._tracebackJ = trace == Trace::none ? Node::_undefined
+                  : trace == Trace::up ? j : j - 1;
+              return node._value != before || gapChanged;
+          }
+          inline bool
+          scoreNode (int i, int j, const int16_t* scores, int lastI, int lastJ)
+          {
+              bool changed;
+              this->kernel (i == lastI, [&] (auto gaps, auto lastRow) {
+                  using TGaps = decltype (gaps);
+                  constexpr bool last = decltype (lastRow)::value;
+                  changed = j == lastJ ? this->template scoreNode<TGaps, last, true> (i, j, scores)
+                      : this->template scoreNode<TGaps, last, false> (i, j, scores);
+              });
+              return changed;
+          }
+
+          /**
+           * updateRow()
+           *
+           * @brief
+           * Score the nodes of a row from one column to another with the kernel of the row.
+           * @param i The row.
+           * @param beginJ, endJ The first and last column scored.
+           * @param lastI, lastJ The last row and column of the matrix.
+           */
+          void
+          updateRow (int i, int beginJ, int endJ, int lastI, int lastJ)
+          {
+              const int16_t* scores = this->_scoreSet.row (this->needleAt (i - 1));
+              this->kernel (i == lastI, [&] (auto gaps, auto lastRow) {
+                  using TGaps = decltype (gaps);
+                  constexpr bool last = decltype (lastRow)::value;
+                  const int end = std::min (endJ, lastJ - 1);
+                  for (int j = beginJ; j <= end; j++)
+                      this->template scoreNode<TGaps, last, false> (i, j, scores);
+                  if (endJ == lastJ)
+                      this->template scoreNode<TGaps, last, true> (i, lastJ, scores);
+              });
+          }
+
+          /**
+           * updateWavefront()
+           *
+           * @brief
+           * Update all nodes in the matrix with tiles of rows and columns, the tiles of one
+           * anti-diagonal are shared among the threads which wait for each other before
+           * the next anti-diagonal.
+           * @param lastI, lastJ The last row and column of the matrix.
+           */
+          void
+          updateWavefront (int lastI, int lastJ)
+          {
+              const int workers = this->_threads;
+              const int tileI = (lastI + 2 * workers - 1) / (2 * workers);
+              const int tileJ = std::max (256, (1 << 14) / tileI);
+              const int rowTiles = (lastI + tileI - 1) / tileI;
+              const int columnTiles = (lastJ + tileJ - 1) / tileJ;
+
+              std::barrier<> wavefront (workers);
+              auto work = [&] (int worker) {
+                  for (int diagonal = 0; diagonal < rowTiles + columnTiles - 1; diagonal++)
+                  {
+                      int first = std::max (0, diagonal - columnTiles + 1);
+                      int last = std::min (diagonal, rowTiles - 1);
+                      for (int tile = first + worker; tile <= last; tile += workers)
+                      {
+                          int beginJ = (diagonal - tile) * tileJ + 1;
+                          int endJ = std::min (beginJ + tileJ - 1, lastJ);
+                          for (int i = tile * tileI + 1; i <= std::min ((tile + 1) * tileI, lastI); i++)
+                              this->updateRow (i, beginJ, endJ, lastI, lastJ);
+                      }
+                      wavefront.arrive_and_wait ();
+                  }
+              };
+
+              std::vector<std::thread> threads;
+              for (int worker = 1; worker < workers; worker++)
+                  threads.emplace_back (work, worker);
+              work (0);
+              for (std::thread& thread : threads)
+                  thread.join ();
+          }
+
+          /**
+           * threshold(), bandRows()
+           *
+           * @brief
+           * The minimum score of a match, and the rows in which a match can still begin and
+           * reach it. Below these rows only nodes next to a node that can still reach the
+           * minimum score have to be scored, every other node keeps a score of zero.
+           */
+          int
+          threshold () const
+          {
+              int minimum = std::max (this->_minimumScore, this->_significantScore);
+              if (this->_maxEdits >= 0)
+              {
+                  const ScoreMatrix& scores = this->_scoreSet;
+                  int edit = std::max (scores._match - scores._lowest,
+                      scores._match + scores._gapOpen + scores._gap);
+                  minimum = std::max (minimum,
+                      (int)this->_needleSequence.length () * scores._match - this->_maxEdits * edit);
+              }
+              return minimum;
+          }
+          int
+          bandRows (int lastI) const
+          {
+              const int threshold = this->threshold ();
+              const int best = this->_scoreSet._highest;
+              if (threshold <= 0)
+                  return lastI;
+              if (best <= 0)
+                  return 0;
+              return std::max (0, lastI + 1 - (threshold + best - 1) / best);
+          }
+
+          /**
+           * updateBanded()
+           *
+           * @brief
+           * Update the nodes of the matrix that can reach the minimum score and their
+           * neighbours, row by row, and queue the nodes scoring at least the minimum as
+           * candidates. Skipped nodes keep a score of zero, which never changes the score
+           * or trace of a node that can reach the minimum.
+           */
+          void
+          updateBanded ()
+          {
+              if (!this->_spanned)
+                  this->spanMatrix ();
+
+              detail::PhaseTimer timer (this->_stats, QueryStats::update);
+              const int lastI = this->_nodes.size () - 1;
+              const int lastJ = this->_nodes[0].size () - 1;
+              const int64_t width = lastJ + 1;
+              const int threshold = this->threshold ();
+              const int best = this->_scoreSet._highest;
+              const int rows = this->bandRows (lastI);
+
+              this->_candidates.clear ();
+              const size_t capacity = this->_candidates.capacity ();
+              uint64_t scored = 0;
+              std::vector<int> above, alive;
+              for (int i = 1; i <= lastI && (i <= rows || !above.empty ()); i++)
+              {
+                  const int16_t* scores = this->_scoreSet.row (this->needleAt (i - 1));
+                  alive.clear ();
+                  auto score = [&] (int j) {
+                      this->scoreNode (i, j, scores, lastI, lastJ);
+                      if constexpr (QueryStats::enabled)
+                          ++scored;
+                      int value = this->_nodes[i][j]._value;
+                      if (value > 0 && value >= threshold)
+                          this->_candidates.emplace_back (value, -(i * width + j));
+                      if (value + (lastI - i) * best < threshold)
+                          return false;
+                      alive.push_back (j);
+                      return true;
+                  };
+
+                  if (i <= rows)
+                  {
+                      for (int j = 1; j <= lastJ; j++)
+                          score (j);
+                  }
+                  else
+                  {
+                      /* A node that can reach the minimum reaches the node below and the
+                       * diagonal one, and the next node of its row */
+                      size_t k = 0;
+                      int j = above.front ();
+                      while (j <= lastJ)
+                      {
+                          bool reaches = score (j);
+                          bool diagonal = k < above.size () && above[k] == j;
+                          while (k < above.size () && above[k] <= j)
+                              ++k;
+                          if (reaches || diagonal)
+                              j++;
+                          else
+                              j = k < above.size () ? above[k] : lastJ + 1;
+                      }
+                  }
+                  std::swap (above, alive);
+              }
+              std::make_heap (this->_candidates.begin (), this->_candidates.end ());
+              if constexpr (QueryStats::enabled)
+              {
+                  this->_stats._cellsComputed += scored;
+                  this->_stats._cellsSkipped += (uint64_t)lastI * lastJ - scored;
+                  this->_stats.grew (capacity, this->_candidates);
+              }
+
+              this->_score = this->_nodes[lastI][lastJ]._value;
+          }
+
+          /**
+           * collectCandidates()
+           *
+           * @brief
+           * Queue every node with a positive score as candidate for the next match.
+           */
+          void
+          collectCandidates ()
+          {
+              detail::PhaseTimer timer (this->_stats, QueryStats::scan);
+              const int64_t width = this->_nodes[0].size ();
+              this->_candidates.clear ();
+              const size_t capacity = this->_candidates.capacity ();
+              for (int i = 1; i < this->_nodes.size (); i++)
+                  for (int j = 1; j < width; j++)
+                      if (this->_nodes[i][j]._value > 0)
+                          this->_candidates.emplace_back (this->_nodes[i][j]._value, -(i * width + j));
+              std::make_heap (this->_candidates.begin (), this->_candidates.end ());
+              if constexpr (QueryStats::enabled)
+                  this->_stats.grew (capacity, this->_candidates);
+          }
+
+          /**
+           * updateRegion()
+           *
+           * @brief
+           * Rescore the nodes of the last traceback and, row by row, every node below and
+           * right of them whose neighbours changed, instead of updating all nodes. Nodes
+           * with a new positive score are queued as candidates.
+           * @param path The nodes of the last traceback.
+           */
+          void
+          updateRegion (std::vector<std::pair<int, int>>& path)
+          {
+              detail::PhaseTimer timer (this->_stats, QueryStats::update);
+              const int lastI = this->_nodes.size () - 1;
+              const int lastJ = this->_nodes[0].size () - 1;
+              const int64_t width = lastJ + 1;
+              const size_t capacity = this->_candidates.capacity ();
+              uint64_t scored = 0;
+              std::sort (path.begin (), path.end ());
+
+              std::vector<int> changed, above, columns;
+              auto dirty = path.begin ();
+              for (int i = path.empty () ? lastI + 1 : path.front ().first; i <= lastI; i++)
+              {
+                  if (above.empty ())
+                  {
+                      if (dirty == path.end ())
+                          break;
+                      i = dirty->first;
+                  }
+
+                  /* A changed node above changes the upper and the diagonal neighbour */
+                  auto rowEnd = dirty;
+                  while (rowEnd != path.end () && rowEnd->first == i)
+                      ++rowEnd;
+                  columns.clear ();
+                  for (int j : above)
+                  {
+                      columns.push_back (j);
+                      if (j < lastJ)
+                          columns.push_back (j + 1);
+                  }
+                  for (auto node = dirty; node != rowEnd; ++node)
+                      columns.push_back (node->second);
+                  std::sort (columns.begin (), columns.end ());
+                  columns.erase (std::unique (columns.begin (), columns.end ()), columns.end ());
+
+                  /* A changed node changes the left neighbour of the next one */
+                  const int16_t* scores = this->_scoreSet.row (this->needleAt (i - 1));
+                  changed.clear ();
+                  size_t k = 0;
+                  int carry = 0;
+                  while (k < columns.size () || carry != 0)
+                  {
+                      int j;
+                      if (carry != 0 && (k == columns.size () || carry <= columns[k]))
+                      {
+                          j = carry;
+                          if (k < columns.size () && columns[k] == carry)
+                              ++k;
+                      }
+                      else
+                      {
+                          j = columns[k++];
+                      }
+                      carry = 0;
+
+                      bool forced = std::binary_search (dirty, rowEnd, std::make_pair (i, j));
+                      if constexpr (QueryStats::enabled)
+                          ++scored;
+                      if (this->scoreNode (i, j, scores, lastI, lastJ) || forced)
+                      {
+                          changed.push_back (j);
+                          if (j < lastJ)
+                              carry = j + 1;
+                          if (this->_nodes[i][j]._value > 0)
+                          {
+                              this->_candidates.emplace_back (this->_nodes[i][j]._value, -(i * width + j));
+                              std::push_heap (this->_candidates.begin (), this->_candidates.end ());
+                          }
+                      }
+                  }
+                  dirty = rowEnd;
+                  std::swap (above, changed);
+              }
+              if constexpr (QueryStats::enabled)
+              {
+                  this->_stats._cellsComputed += scored;
+                  this->_stats._cellsSkipped += (uint64_t)lastI * lastJ - scored;
+                  this->_stats.grew (capacity, this->_candidates);
+              }
+
+              this->_score = this->_nodes[lastI][lastJ]._value;
+          }
+
+          /**
+           * step()
+           *
+           * @brief
+           * Score one node from its upper, left and diagonal neighbour, gaps along the last
+           * row and column are free and nodes of earlier matches are reset.
+           * @param lastRow, lastColumn Whether the node lies on the last row or column.
+           * @param up, left, diagonal The scores of the neighbours.
+           * @param substitution The score of the characters compared by the node.
+           * @param matched Whether the node was part of an earlier match.
+           * @param trace Receives the neighbour the node was scored from.
+           * @return The score of the node.
+           */
+          inline int
+          step (bool lastRow, bool lastColumn, int up, int left, int diagonal,
+                int substitution, bool matched, Trace& trace)
+          {
+              if (matched)
+                  return this->choose (0, 0, 0, trace);
+              return this->choose (lastColumn ? up : up - this->_scoreSet._gap,
+                  lastRow ? left : left - this->_scoreSet._gap, diagonal + substitution, trace);
+          }
+
+          /**
+           * choose()
+           *
+           * @brief
+           * Pick the score of a node from the scores reached from the upper, left and diagonal
+           * neighbour. In the hybrid mode ties between the upper and left one resolve to the
+           * diagonal one, other modes pick the best score and prefer the diagonal neighbour
+           * and then the upper one. Clamped scores below zero end the alignment.
+           * @param a, b, c The scores reached from the upper, left and diagonal neighbour.
+           * @param trace Receives the neighbour the node was scored from.
+           * @return The score of the node.
+           */
+          template <typename TMode = detail::HybridAlignment>
+          inline int
+          choose (int a, int b, int c, Trace& trace)
+          {
+              int value;
+              if (TMode::diagonalTies ? (a > b) && (a > c) : a > c && a >= b)
+              {
+                  value = a;
+                  trace = Trace::up;
+              }
+              else if (TMode::diagonalTies ? (b > c) && (b > a) : b > c)
+              {
+                  value = b;
+                  trace = Trace::left;
+              }
+              else
+              {
+                  value = c;
+                  trace = Trace::diagonal;
+              }
+              if (TMode::clamped && value < 0)
+              {
+                  value = 0;
+                  trace = Trace::none;
+              }
+              return value;
+          }
+
+          /**
+           * traceback()
+           *
+           * @brief
+           * Follow the traces from the end node of a match and record the aligned sequences,
+           * gaps in front of the last aligned pair are not part of the match unless the whole
+           * path is. A whole path also follows the traces along the first row and column.
+           * @param maxNodeI, maxNodeJ The end node of the match.
+           * @param score The score of the match.
+           * @param trace Callable that returns the trace of a node.
+           * @param mask Callable that marks a node as part of the match.
+           * @param whole Whether the match ends in the end node and gaps at its ends belong to it.
+           * @return The node the traceback ended on.
+           */
+          template <typename TTrace, typename TMask>
+          std::pair<int, int>
+          traceback (int maxNodeI, int maxNodeJ, int score, TTrace&& trace, TMask&& mask,
+                     bool whole = false)
+          {
+              detail::PhaseTimer timer (this->_stats, QueryStats::traceback);
+              if constexpr (QueryStats::enabled)
+                  ++this->_stats._tracebacks;
+              int currentI = maxNodeI;
+              int currentJ = maxNodeJ;
+              Trace currentTrace = trace (currentI, currentJ);
+
+              detail::EditScript script;
+              int endNeedle = whole ? maxNodeI : Node::_undefined;
+              int endHaystack = whole ? maxNodeJ : Node::_undefined;
+
+              while (currentTrace != Trace::none)
+              {
+                  if (!whole && (currentI == 0 || currentJ == 0))
+                  {
+                      break;
+                  }
+
+                  if (currentTrace == Trace::diagonal)
+                  {
+                      if (endNeedle == Node::_undefined)
+                      {
+                          endNeedle = currentI;
+                          endHaystack = currentJ;
+                      }
+                      script.push ('M');
+                  }
+                  else if (currentTrace == Trace::left)
+                  {
+                      if (endNeedle != Node::_undefined)
+                          script.push ('D');
+                  }
+                  else
+                  {
+                      if (endNeedle != Node::_undefined)
+                          script.push ('I');
+                  }
+
+                  mask (currentI, currentJ);
+                  if constexpr (QueryStats::enabled)
+                      ++this->_stats._tracebackLength;
+
+                  if (currentTrace != Trace::left)
+                      --currentI;
+                  if (currentTrace != Trace::up)
+                      --currentJ;
+
+                  currentTrace = trace (currentI, currentJ);
+              }
+
+              this->_matches.emplace_back (this->needleSource (), this->_haystack, script.cigar (),
+                  score, currentI + 1, endNeedle, this->column (currentJ + 1),
+                  this->column (endHaystack), this->_parser);
+              return { currentI, currentJ };
+          }
+
+          /**
+           * searchStrands()
+           *
+           * @brief
+           * Search the strands of the haystack with one query and one pass per strand on the
+           * shared haystack and keep the best matches of both, the query of the reverse strand
+           * reads the needle through its reverse complement view. Matches of one strand may
+           * overlap like in a single search, matches that overlap a kept match of the other
+           * strand are dropped. Needle positions of matches on the reverse strand refer to
+           * the needle as it was given.
+           */
+          std::list<Match<Tp>>&
+          searchStrands ()
+          {
+              const size_t lastI = this->_needleSequence.length ();
+              std::vector<std::pair<Match<Tp>, std::vector<SeedHit>>> found;
+              for (Strand strand : { Strand::forward, Strand::reverse })
+              {
+                  if (this->_strand != Strand::both && this->_strand != strand)
+                      continue;
+                  FuzzyQuery<Tp> query (this->_haystack, this->_needleSequence);
+                  query._reverse = strand == Strand::reverse;
+                  query.initializeScoreMatrix (this->_scoreSet, this->_amount);
+                  query.setItemParser (this->_parser);
+                  query.setMemoryMode (this->_memoryMode);
+                  query.setEngine (this->_engine);
+                  query.setAlignmentMode (this->_alignmentMode);
+                  query.setThreads (this->_threads);
+                  query.setMinimumScore (std::max (this->_minimumScore, this->_significantScore));
+                  query.setMaxEdits (this->_maxEdits);
+                  query.setSeeding (this->_seeding);
+                  query.setCircular (this->_circular);
+                  std::list<Match<Tp>>& matches = query.search ();
+                  this->_stats += query.stats ();
+                  size_t k = 0;
+                  for (Match<Tp>& match : matches)
+                  {
+                      match._strand = strand;
+                      if (strand == Strand::reverse
+                          && match._needle._end != (size_t)Node::_undefined)
+                      {
+                          size_t start = match._needle._start;
+                          match._needle._start = lastI + 1 - match._needle._end;
+                          match._needle._end = lastI + 1 - start;
+                      }
+                      found.emplace_back (match, k < query.seeds ().size ()
+                          ? query.seeds ()[k] : std::vector<SeedHit> ());
+                      ++k;
+                  }
+              }
+
+              std::stable_sort (found.begin (), found.end (), [] (const auto& a, const auto& b) {
+                  return a.first._score > b.first._score;
+              });
+              std::map<int64_t, int64_t> kept[2];
+              int hitCount = 0;
+              for (size_t k = 0; k < found.size () && hitCount < this->_amount; ++k)
+              {
+                  const Match<Tp>& match = found[k].first;
+                  const int strand = match._strand == Strand::reverse;
+                  if (match._haystack._end != (size_t)Node::_undefined)
+                  {
+                      if (this->overlaps (kept[1 - strand], match._haystack._start, match._haystack._end))
+                          continue;
+                      this->cover (kept[strand], match._haystack._start, match._haystack._end);
+                  }
+                  this->_matches.push_back (match);
+                  if (!this->_seeding._pattern.empty ())
+                      this->_seeds.push_back (found[k].second);
+                  hitCount++;
+              }
+              return this->_matches;
+          }
+
+          /**
+           * searchSeeded()
+           *
+           * @brief
+           * Find the seeds of the needle in the haystack, group them by diagonal into windows
+           * of the haystack and search every window that has enough seeds on its own. The
+           * best matches of all windows are kept.
+           */
+          std::list<Match<Tp>>&
+          searchSeeded ()
+          {
+              const detail::SeedIndex& index = this->_haystack->seedIndex (this->_seeding._pattern);
+              const int span = this->_seeding._pattern.size ();
+              const int margin = std::max (0, this->_seeding._margin);
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const int length = this->_haystack->sequence.length ();
+
+              std::string needle (lastI, '\0');
+              for (int i = 0; i < lastI; ++i)
+                  needle[i] = tolower (this->needleAt (i));
+
+              /* Seeds in the repeated start of a circular haystack are found at the start */
+              std::vector<SeedHit> hits;
+              for (int i = 0; i + span <= lastI; ++i)
+              {
+                  uint64_t key;
+                  if (index.key (needle.data () + i, key))
+                      index.find (key, [&hits, i, length] (int j) {
+                          if (j < length)
+                              hits.push_back ({ i, j });
+                      });
+              }
+              std::sort (hits.begin (), hits.end (), [] (const SeedHit& a, const SeedHit& b) {
+                  int diagonalA = a._haystack - a._needle;
+                  int diagonalB = b._haystack - b._needle;
+                  return diagonalA != diagonalB ? diagonalA < diagonalB : a._haystack < b._haystack;
+              });
+
+              /* Seeds on diagonals closer than the margin form one window */
+              struct Window
+              {
+                  int begin;
+                  int end;
+                  std::vector<SeedHit> seeds;
+              };
+              std::vector<Window> windows;
+              for (size_t first = 0, last; first < hits.size (); first = last)
+              {
+                  last = first + 1;
+                  while (last < hits.size ()
+                      && (hits[last]._haystack - hits[last]._needle)
+                          - (hits[last - 1]._haystack - hits[last - 1]._needle) <= margin)
+                      ++last;
+                  if ((int)(last - first) < this->_seeding._hits)
+                      continue;
+                  int begin = hits[first]._haystack - hits[first]._needle - margin;
+                  int end = hits[last - 1]._haystack - hits[last - 1]._needle + lastI + margin;
+                  windows.push_back ({ std::max (0, begin), std::min (lastJ, end),
+                      std::vector<SeedHit> (hits.begin () + first, hits.begin () + last) });
+              }
+              std::sort (windows.begin (), windows.end (), [] (const Window& a, const Window& b) {
+                  return a.begin < b.begin;
+              });
+              std::vector<Window> merged;
+              for (Window& window : windows)
+              {
+                  if (!merged.empty () && window.begin <= merged.back ().end)
+                  {
+                      merged.back ().end = std::max (merged.back ().end, window.end);
+                      merged.back ().seeds.insert (merged.back ().seeds.end (),
+                          window.seeds.begin (), window.seeds.end ());
+                  }
+                  else
+                  {
+                      merged.push_back (std::move (window));
+                  }
+              }
+
+              std::vector<std::pair<Match<Tp>, std::vector<SeedHit>>> found;
+              for (const Window& window : merged)
+              {
+                  Tp part;
+                  for (int j = window.begin; j < window.end; ++j)
+                      part += this->_haystack->sequence[this->column (j + 1) - 1];
+                  FuzzyQuery<Tp> query (std::move (part), this->_needleSequence);
+                  query._reverse = this->_reverse;
+                  query.initializeScoreMatrix (this->_scoreSet, this->_amount);
+                  query.setItemParser (this->_parser);
+                  query.setMemoryMode (this->_memoryMode);
+                  query.setEngine (this->_engine);
+                  query.setAlignmentMode (this->_alignmentMode);
+                  query.setThreads (this->_threads);
+                  query.setMinimumScore (std::max (this->_minimumScore, this->_significantScore));
+                  query.setMaxEdits (this->_maxEdits);
+                  std::list<Match<Tp>>& matches = query.search ();
+                  this->_stats += query.stats ();
+                  for (Match<Tp>& match : matches)
+                  {
+                      if (match._haystack._start != (size_t)Node::_undefined)
+                          match._haystack._start += window.begin;
+                      if (match._haystack._end != (size_t)Node::_undefined)
+                          match._haystack._end += window.begin;
+
+                      /* Report the seeds inside the match, or the seeds of its window */
+                      std::vector<SeedHit> seeds;
+                      for (const SeedHit& seed : window.seeds)
+                          if (seed._haystack + 1 >= (int)match._haystack._start
+                              && seed._haystack + span <= (int)match._haystack._end)
+                              seeds.push_back (seed);
+                      match._haystack._start = this->column (match._haystack._start);
+                      match._haystack._end = this->column (match._haystack._end);
+                      found.emplace_back (match, seeds.empty () ? window.seeds : seeds);
+                  }
+              }
+
+              std::stable_sort (found.begin (), found.end (), [] (const auto& a, const auto& b) {
+                  return a.first._score > b.first._score;
+              });
+              for (size_t k = 0; k < found.size () && (int)k < this->_amount; ++k)
+              {
+                  this->_matches.push_back (found[k].first);
+                  this->_seeds.push_back (found[k].second);
+              }
+              return this->_matches;
+          }
+
+          /**
+           * searchBitParallel()
+           *
+           * @brief
+           * Search with the bit-parallel engine, the edit distance of the whole needle is
+           * computed for every end in the haystack in one pass. Ends with fewer edits than
+           * their neighbours are aligned in order of their edits and then their position,
+           * ends whose alignment overlaps an earlier match are dropped. An alignment spans at
+           * least as many haystack positions as the needle has characters beyond its edits,
+           * so ends that overlap an earlier match with that span are dropped before they are
+           * aligned, and the search stops once no gap between the matches is wide enough.
+           */
+          std::list<Match<Tp>>&
+          searchBitParallel ()
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              if (lastI == 0)
+                  return this->_matches;
+              std::string needle (lastI, '\0');
+              for (int i = 0; i < lastI; ++i)
+                  needle[i] = tolower (this->needleAt (i));
+
+              /* The whole needle against nothing but gaps are not a match */
+              const int limit = this->_maxEdits >= 0 ? std::min (this->_maxEdits, lastI - 1) : lastI - 1;
+              std::vector<std::pair<int, int>> candidates;
+              int left = lastI;
+              int middle = lastI;
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::update);
+                  detail::BitPattern (needle).scan (
+                      std::string_view (this->_haystack->characters).substr (0, lastJ),
+                      [&] (int end, int edits) {
+                          if (end > 1 && middle < left && middle <= edits && middle <= limit)
+                              candidates.emplace_back (-middle, 1 - end);
+                          left = middle;
+                          middle = edits;
+                      });
+              }
+              if (lastJ > 0 && middle < left && middle <= limit)
+                  candidates.emplace_back (-middle, -lastJ);
+              std::make_heap (candidates.begin (), candidates.end ());
+              if constexpr (QueryStats::enabled)
+              {
+                  this->_stats._cellsComputed += (uint64_t)lastI * lastJ;
+                  this->_stats.grew (0, candidates);
+              }
+
+              const int minimum = std::max (this->_minimumScore, this->_significantScore);
+              std::map<int64_t, int64_t> found;
+              int hitCount = 0;
+              while (hitCount < this->_amount && !candidates.empty ())
+              {
+                  std::pair<int, int> top = candidates.front ();
+                  std::pop_heap (candidates.begin (), candidates.end ());
+                  candidates.pop_back ();
+
+                  const int end = -top.second;
+                  const int span = lastI + top.first;
+                  if (this->overlaps (found, this->column (std::max (1, end - span + 1)), this->column (end)))
+                      continue;
+                  Match<Tp> match = this->alignEdits (needle, end, -top.first);
+                  if (match._score < minimum
+                      || !this->claim (found, match._haystack._start, match._haystack._end))
+                      continue;
+                  this->_matches.push_back (match);
+                  hitCount++;
+                  if (this->longestGap (found) < lastI - limit)
+                      break;
+              }
+              return this->_matches;
+          }
+
+          /**
+           * overlaps(), claim(), cover()
+           *
+           * @brief
+           * Whether haystack positions overlap an earlier match, and keep the positions of a
+           * match unless they do, or merge them with those they overlap. The matches are kept
+           * by their start, matches across the origin of a circular haystack end before they
+           * start and are kept as ending behind the end of the haystack.
+           * @param found The positions of the earlier matches.
+           * @param start, end The first and last haystack position of the match.
+           * @return Whether the positions were kept.
+           */
+          bool
+          overlaps (const std::map<int64_t, int64_t>& found, size_t start, size_t end) const
+          {
+              const int64_t length = this->_haystack->sequence.length ();
+              const int64_t last = (int64_t)end + (end < start ? length : 0);
+              const int shifts = this->_circular ? 1 : 0;
+              for (int shift = -shifts; shift <= shifts; ++shift)
+              {
+                  /* The matches are disjoint, so only the last one starting before the end
+                   * can reach the start */
+                  auto next = found.upper_bound (last + shift * length);
+                  if (next != found.begin () && std::prev (next)->second >= (int64_t)start + shift * length)
+                      return true;
+              }
+              return false;
+          }
+          bool
+          claim (std::map<int64_t, int64_t>& found, size_t start, size_t end) const
+          {
+              if (this->overlaps (found, start, end))
+                  return false;
+              found.emplace (start, (int64_t)end + (end < start ? this->_haystack->sequence.length () : 0));
+              return true;
+          }
+          void
+          cover (std::map<int64_t, int64_t>& found, size_t start, size_t end) const
+          {
+              int64_t first = start;
+              int64_t last = (int64_t)end + (end < start ? this->_haystack->sequence.length () : 0);
+              for (auto next = found.upper_bound (last);
+                  next != found.begin () && std::prev (next)->second >= first;)
+              {
+                  next = std::prev (next);
+                  first = std::min (first, next->first);
+                  last = std::max (last, next->second);
+                  next = found.erase (next);
+              }
+              found.emplace (first, last);
+          }
+
+          /**
+           * longestGap()
+           *
+           * @brief
+           * The most haystack positions in a row that no earlier match overlaps, on a circular
+           * haystack the positions in front of the first match follow those behind the last.
+           * @param found The positions of the earlier matches.
+           */
+          int64_t
+          longestGap (const std::map<int64_t, int64_t>& found) const
+          {
+              const int64_t length = this->_haystack->sequence.length ();
+              if (found.empty ())
+                  return length;
+              const int64_t wrapped = this->_circular
+                  ? std::max<int64_t> (0, found.rbegin ()->second - length) : 0;
+              int64_t longest = 0;
+              int64_t after = 1 + wrapped;
+              for (const auto& [start, end] : found)
+              {
+                  longest = std::max (longest, start - after);
+                  after = end + 1;
+              }
+              int64_t trailing = length + 1 - after;
+              if (this->_circular && wrapped == 0)
+                  trailing += found.begin ()->first - 1;
+              return std::max (longest, trailing);
+          }
+
+          /**
+           * alignEdits()
+           *
+           * @brief
+           * Align the whole needle with the fewest edits to the haystack ending at a position,
+           * in a window just wide enough for the edits. The match is scored with the score
+           * matrix of the query.
+           * @param needle The lowered needle characters.
+           * @param end The last haystack position of the alignment, counted from one.
+           * @param edits The edit distance of the alignment.
+           */
+          Match<Tp>
+          alignEdits (const std::string& needle, int end, int edits)
+          {
+              detail::PhaseTimer timer (this->_stats, QueryStats::traceback);
+              const std::string& characters = this->_haystack->characters;
+              const int lastI = needle.size ();
+              const int begin = std::max (0, end - lastI - edits);
+              const int width = end - begin + 1;
+              std::vector<int> distances ((size_t)(lastI + 1) * width, 0);
+              if constexpr (QueryStats::enabled)
+              {
+                  ++this->_stats._tracebacks;
+                  this->_stats._cellsComputed += (uint64_t)lastI * (width - 1);
+                  this->_stats.grew (0, distances);
+              }
+              auto at = [width] (int i, int j) { return (size_t)i * width + j; };
+              auto differs = [&] (int i, int j) { return (int)(needle[i - 1] != characters[begin + j - 1]); };
+              for (int i = 1; i <= lastI; ++i)
+              {
+                  distances[at (i, 0)] = i;
+                  for (int j = 1; j < width; ++j)
+                      distances[at (i, j)] = std::min ({ distances[at (i - 1, j - 1)] + differs (i, j),
+                          distances[at (i - 1, j)] + 1, distances[at (i, j - 1)] + 1 });
+              }
+
+              detail::EditScript script;
+              int score = 0;
+              int i = lastI;
+              int j = width - 1;
+              Trace last = Trace::none;
+              while (i > 0)
+              {
+                  Trace next;
+                  if (j > 0 && distances[at (i, j)] == distances[at (i - 1, j - 1)] + differs (i, j))
+                  {
+                      next = Trace::diagonal;
+                      script.push ('M');
+                      score += this->_scoreSet.getScore (characters[begin + j - 1], needle[i - 1]);
+                      --i;
+                      --j;
+                  }
+                  else if (distances[at (i, j)] == distances[at (i - 1, j)] + 1)
+                  {
+                      next = Trace::up;
+                      script.push ('I');
+                      --i;
+                  }
+                  else
+                  {
+                      next = Trace::left;
+                      script.push ('D');
+                      --j;
+                  }
+                  if (next != Trace::diagonal)
+                      score -= this->_scoreSet._gap + (next != last ? this->_scoreSet._gapOpen : 0);
+                  last = next;
+                  if constexpr (QueryStats::enabled)
+                      ++this->_stats._tracebackLength;
+              }
+              return Match<Tp> (this->needleSource (), this->_haystack, script.cigar (), score,
+                  1, lastI, this->column (begin + j + 1), this->column (end), this->_parser);
+          }
+
+          /**
+           * searchLinear()
+           *
+           * @brief
+           * Search in linear memory, every match costs one sweep over two columns of scores
+           * that also carries the column each traceback would end on, and the traces are
+           * rebuilt from the columns between that one and the end node.
+           */
+          std::list<Match<Tp>>&
+          searchLinear ()
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              std::string needle (lastI, '\0');
+              for (int i = 0; i < lastI; ++i)
+                  needle[i] = this->needleAt (i);
+
+              std::vector<int> previous (lastI + 1), current (lastI + 1);
+              std::vector<int> previousJ (lastI + 1), currentJ (lastI + 1);
+              if constexpr (QueryStats::enabled)
+                  for (const std::vector<int>* column
+                      : { &previous, &current, &previousJ, &currentJ })
+                      this->_stats.grew (0, *column);
+              const int threshold = this->threshold ();
+              const int best = this->_scoreSet._highest;
+              const int rows = this->bandRows (lastI);
+
+              int hitCount = 0;
+              while (hitCount < this->_amount)
+              {
+                  int maxNodeValue = 0;
+                  int maxNodeI = Node::_undefined;
+                  int maxNodeJ = Node::_undefined;
+                  int originJ = 0;
+
+                  for (int i = 0; i <= lastI; ++i)
+                  {
+                      previous[i] = 0;
+                      current[i] = 0;
+                      previousJ[i] = 0;
+                  }
+
+                  /* Columns end below the last node that can reach the minimum score, the
+                   * rows after the end of a column are reset for the next column */
+                  int previousAlive = 0;
+                  int currentEnd = 0;
+                  int previousEnd = 0;
+                  size_t matched = 0;
+                  {
+                      detail::PhaseTimer timer (this->_stats, QueryStats::update);
+                      for (int j = 1; j <= lastJ; ++j)
+                      {
+                          char haystack = this->_haystack->characters[j - 1];
+                          current[0] = 0;
+                          currentJ[0] = j;
+                          for (; matched < this->_matched.size ()
+                              && this->_matched[matched] < FuzzyQuery<Tp>::key (0, j); ++matched);
+
+                          int end = std::min (lastI, std::max (rows, previousAlive + 1));
+                          int alive = 0;
+                          for (int i = 1; i <= end; ++i)
+                          {
+                              bool isMatched = matched < this->_matched.size ()
+                                  && this->_matched[matched] == FuzzyQuery<Tp>::key (i, j);
+                              matched += isMatched;
+
+                              Trace trace;
+                              current[i] = this->step (i == lastI, j == lastJ, current[i - 1],
+                                  previous[i], previous[i - 1],
+                                  this->_scoreSet.getScore (haystack, needle[i - 1]), isMatched, trace);
+
+                              switch (trace)
+                              {
+                                  case Trace::up:
+                                      currentJ[i] = currentJ[i - 1];
+                                      break;
+                                  case Trace::left:
+                                      currentJ[i] = previousJ[i];
+                                      break;
+                                  case Trace::diagonal:
+                                      currentJ[i] = previousJ[i - 1];
+                                      break;
+                                  default:
+                                      currentJ[i] = j;
+                                      break;
+                              }
+
+                              /* Ties go to the node that comes first in row order like in the matrix mode. */
+                              if (current[i] > maxNodeValue
+                                  || (current[i] == maxNodeValue && maxNodeValue > 0 && i < maxNodeI))
+                              {
+                                  maxNodeValue = current[i];
+                                  maxNodeI = i;
+                                  maxNodeJ = j;
+                                  originJ = currentJ[i];
+                              }
+
+                              if (current[i] + (lastI - i) * best >= threshold)
+                              {
+                                  alive = i;
+                                  end = std::max (end, std::min (lastI, i + 1));
+                              }
+                          }
+                          for (int i = end + 1; i <= currentEnd; ++i)
+                              current[i] = 0;
+                          if constexpr (QueryStats::enabled)
+                          {
+                              this->_stats._cellsComputed += end;
+                              this->_stats._cellsSkipped += lastI - end;
+                          }
+                          currentEnd = end;
+                          previousAlive = alive;
+
+                          std::swap (currentEnd, previousEnd);
+                          std::swap (previous, current);
+                          std::swap (previousJ, currentJ);
+                      }
+                  }
+                  this->_score = previous[lastI];
+
+                  if (maxNodeValue == 0 || maxNodeValue < threshold)
+                  {
+                      break;
+                  }
+
+                  /* The traces start from the scores of the column before the origin of the
+                   * match, or from the first column should they cross it */
+                  std::vector<Trace> path;
+                  {
+                      detail::PhaseTimer timer (this->_stats, QueryStats::traceback);
+                      std::vector<int> column (maxNodeI + 1, 0);
+                      const int leftJ = std::max (originJ, 1);
+                      this->sweepColumns (needle, column, 1, leftJ - 1,
+                          [] (int, const std::vector<int>&) {});
+                      int i = maxNodeI;
+                      int j = maxNodeJ;
+                      if (!this->tracePath (needle, column, leftJ, i, j, path))
+                          this->tracePath (needle, std::vector<int> (i + 1, 0), 1, i, j, path);
+                  }
+
+                  size_t pathIndex = 0;
+                  auto trace = [&] (int, int) {
+                      return pathIndex < path.size () ? path[pathIndex++] : Trace::none;
+                  };
+                  std::vector<uint64_t> masked;
+                  auto mask = [&] (int i, int j) {
+                      for (int column : { j, this->twin (j) })
+                          if (column != Node::_undefined && (i != maxNodeI || column != maxNodeJ))
+                              masked.push_back (FuzzyQuery<Tp>::key (i, column));
+                  };
+                  this->traceback (maxNodeI, maxNodeJ, maxNodeValue, trace, mask);
+
+                  std::sort (masked.begin (), masked.end ());
+                  size_t middle = this->_matched.size ();
+                  size_t capacity = this->_matched.capacity ();
+                  this->_matched.insert (this->_matched.end (), masked.begin (), masked.end ());
+                  if constexpr (QueryStats::enabled)
+                      this->_stats.grew (capacity, this->_matched);
+                  std::inplace_merge (this->_matched.begin (), this->_matched.begin () + middle,
+                      this->_matched.end ());
+                  this->_matched.erase (std::unique (this->_matched.begin (), this->_matched.end ()),
+                      this->_matched.end ());
+                  hitCount++;
+              }
+              return this->_matches;
+          }
+
+          /**
+           * sweepColumns()
+           *
+           * @brief
+           * Score the columns that follow a column of known scores in linear memory, nodes of
+           * earlier matches are reset and nothing is skipped.
+           * @param column The scores of the column before firstJ down to the last row that is
+           * needed, receives the scores of column endJ.
+           * @param firstJ, endJ The first and last column to score.
+           * @param visit Called with every column and its scores.
+           */
+          template <typename TVisit>
+          void
+          sweepColumns (const std::string& needle, std::vector<int>& column, int firstJ, int endJ,
+                        TVisit&& visit)
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const int bottomI = column.size () - 1;
+              std::vector<int> current (column.size (), 0);
+              if constexpr (QueryStats::enabled)
+              {
+                  this->_stats._cellsComputed += (uint64_t)bottomI * std::max (endJ - firstJ + 1, 0);
+                  this->_stats.grew (0, current);
+              }
+
+              auto matched = std::lower_bound (this->_matched.begin (), this->_matched.end (),
+                  FuzzyQuery<Tp>::key (0, firstJ));
+              for (int j = firstJ; j <= endJ; ++j)
+              {
+                  char haystack = this->_haystack->characters[j - 1];
+                  for (; matched != this->_matched.end ()
+                      && *matched < FuzzyQuery<Tp>::key (0, j); ++matched);
+
+                  for (int i = 1; i <= bottomI; ++i)
+                  {
+                      bool isMatched = matched != this->_matched.end ()
+                          && *matched == FuzzyQuery<Tp>::key (i, j);
+                      matched += isMatched;
+
+                      Trace step;
+                      current[i] = this->step (i == lastI, j == lastJ, current[i - 1],
+                          column[i], column[i - 1],
+                          this->_scoreSet.getScore (haystack, needle[i - 1]), isMatched, step);
+                  }
+                  std::swap (column, current);
+                  visit (j, column);
+              }
+          }
+
+          /**
+           * tracePath()
+           *
+           * @brief
+           * Follow the traces of a match back from a node in linear memory. When the scores
+           * between the node and the first column do not fit the budget, the columns right
+           * of the middle one are traced from its scores, found by a sweep over the left half,
+           * and the left half from the node the traces left off on. Every node is scored like
+           * in the first sweep, so the traces are the same as in the matrix mode.
+           * @param column The scores of the column before leftJ down to row i.
+           * @param leftJ The first column to trace.
+           * @param i, j The node to follow, receive the node the traces left off on.
+           * @param path Receives the traces in the order of the traceback.
+           * @return Whether the traces ended before they left column leftJ.
+           */
+          bool
+          tracePath (const std::string& needle, const std::vector<int>& column, int leftJ,
+                     int& i, int& j, std::vector<Trace>& path)
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const size_t width = j - leftJ + 2;
+              const size_t height = i + 1;
+              const size_t budget = std::max ((size_t)4 * (lastI + lastJ + 2), (size_t)1 << 20);
+
+              if (j - leftJ >= 2 && width * height > budget)
+              {
+                  const int middleJ = (leftJ + j) / 2;
+                  std::vector<int> middle (column.begin (), column.begin () + i + 1);
+                  this->sweepColumns (needle, middle, leftJ, middleJ,
+                      [] (int, const std::vector<int>&) {});
+                  if (this->tracePath (needle, middle, middleJ + 1, i, j, path))
+                      return true;
+                  return this->tracePath (needle, column, leftJ, i, j, path);
+              }
+
+              std::vector<int> rectangle (height * width);
+              if constexpr (QueryStats::enabled)
+                  this->_stats.grew (0, rectangle);
+              auto at = [&] (int ri, int rj) -> int& {
+                  return rectangle[ri * width + (rj - leftJ + 1)];
+              };
+              for (int ri = 0; ri <= i; ++ri)
+                  at (ri, leftJ - 1) = column[ri];
+              std::vector<int> sweep (column.begin (), column.begin () + i + 1);
+              this->sweepColumns (needle, sweep, leftJ, j, [&] (int rj, const std::vector<int>& scores) {
+                  for (int ri = 0; ri <= i; ++ri)
+                      at (ri, rj) = scores[ri];
+              });
+
+              while (j >= leftJ)
+              {
+                  if (i == 0 || j == 0)
+                      return true;
+
+                  Trace step;
+                  this->step (i == lastI, j == lastJ, at (i - 1, j), at (i, j - 1), at (i - 1, j - 1),
+                      this->_scoreSet.getScore (this->_haystack->characters[j - 1], needle[i - 1]),
+                      this->isMatched (i, j), step);
+                  path.push_back (step);
+                  if (step == Trace::none)
+                      return true;
+                  if (step != Trace::left)
+                      --i;
+                  if (step != Trace::up)
+                      --j;
+              }
+              return false;
+          }
+
+          /**
+           * searchCompact()
+           *
+           * @brief
+           * Search in the compact memory mode, the scores are only kept for two rows while
+           * every node keeps the neighbour it was scored from in two bits, two more bits
+           * tell whether its gaps extend those of the neighbours when gaps are affine.
+           * Earlier matches are masked in a bitmap and every match fills the matrix again.
+           */
+          std::list<Match<Tp>>&
+          searchCompact ()
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const size_t stride = (lastJ >> 6) + 1;
+              const size_t pairs = (lastJ >> 5) + 1;
+              const bool affine = this->_scoreSet._gapOpen != 0;
+              std::vector<int> previous, current, vertical;
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::initialize);
+                  const size_t capacities[] = { this->_matchedBits.capacity (),
+                      this->_directions.capacity (), this->_extensions.capacity () };
+                  if (this->_matchedBits.empty ())
+                      this->_matchedBits.assign ((lastI + 1) * stride, 0);
+                  this->_directions.resize ((size_t)(lastI + 1) * pairs);
+                  if (affine)
+                      this->_extensions.resize (this->_directions.size ());
+                  previous.resize (lastJ + 1);
+                  current.resize (lastJ + 1);
+                  vertical.resize (lastJ + 1);
+                  if constexpr (QueryStats::enabled)
+                  {
+                      this->_stats.grew (capacities[0], this->_matchedBits);
+                      this->_stats.grew (capacities[1], this->_directions);
+                      this->_stats.grew (capacities[2], this->_extensions);
+                      for (const std::vector<int>* row : { &previous, &current, &vertical })
+                          this->_stats.grew (0, *row);
+                  }
+              }
+
+              int hitCount = 0;
+              while (hitCount < this->_amount)
+              {
+                  int maxNodeValue = 0;
+                  int maxNodeI = Node::_undefined;
+                  int maxNodeJ = Node::_undefined;
+                  {
+                      detail::PhaseTimer timer (this->_stats, QueryStats::update);
+                      std::fill (previous.begin (), previous.end (), 0);
+                      std::fill (vertical.begin (), vertical.end (), detail::GapScores::_closed);
+                      for (int i = 1; i <= lastI; ++i)
+                      {
+                          const int16_t* scores = this->_scoreSet.row (this->needleAt (i - 1));
+                          const uint64_t* matched = this->_matchedBits.data () + i * stride;
+                          uint64_t* directions = this->_directions.data () + i * pairs;
+                          uint64_t* extensions = affine ? this->_extensions.data () + i * pairs : nullptr;
+                          this->kernel (i == lastI, [&] (auto gaps, auto lastRow) {
+                              using TGaps = decltype (gaps);
+                              constexpr bool last = decltype (lastRow)::value;
+                              uint64_t directionWord = 0;
+                              uint64_t extensionWord = 0;
+                              int horizontal = detail::GapScores::_closed;
+                              current[0] = 0;
+                              auto node = [&] (int j, auto lastColumn) {
+                                  bool isMatched = (matched[j >> 6] >> (j & 63)) & 1;
+                                  int substitution = scores[(unsigned char)this->_haystack->characters[j - 1]];
+                                  unsigned char extends = 0;
+                                  Trace trace;
+                                  if (isMatched)
+                                  {
+                                      vertical[j] = detail::GapScores::_closed;
+                                      horizontal = detail::GapScores::_closed;
+                                      current[j] = this->choose (0, 0, 0, trace);
+                                  }
+                                  else
+                                  {
+                                      current[j] = this->cell<detail::HybridAlignment, TGaps, last,
+                                          decltype (lastColumn)::value> (
+                                          previous[j], current[j - 1], previous[j - 1], substitution,
+                                          vertical[j], horizontal, extends, trace);
+                                  }
+                                  directionWord |= (uint64_t)trace << ((j & 31) * 2);
+                                  if constexpr (TGaps::affine)
+                                      extensionWord |= (uint64_t)extends << ((j & 31) * 2);
+                                  if ((j & 31) == 31 || decltype (lastColumn)::value)
+                                  {
+                                      directions[j >> 5] = directionWord;
+                                      directionWord = 0;
+                                      if constexpr (TGaps::affine)
+                                      {
+                                          extensions[j >> 5] = extensionWord;
+                                          extensionWord = 0;
+                                      }
+                                  }
+                                  if (current[j] > maxNodeValue)
+                                  {
+                                      maxNodeValue = current[j];
+                                      maxNodeI = i;
+                                      maxNodeJ = j;
+                                  }
+                              };
+                              for (int j = 1; j < lastJ; ++j)
+                                  node (j, std::false_type ());
+                              if (lastJ > 0)
+                                  node (lastJ, std::true_type ());
+                          });
+                          previous.swap (current);
+                      }
+                      if constexpr (QueryStats::enabled)
+                          this->_stats._cellsComputed += (uint64_t)lastI * lastJ;
+                  }
+
+                  if (maxNodeValue == 0 || maxNodeValue < this->threshold ())
+                  {
+                      break;
+                  }
+
+                  /* A gap that extends the gap of its neighbour continues there */
+                  Trace gap = Trace::none;
+                  auto trace = [&] (int i, int j) {
+                      if (i == 0 || j == 0)
+                          return Trace::none;
+                      size_t word = i * pairs + (j >> 5);
+                      int shift = (j & 31) * 2;
+                      Trace next = gap;
+                      if (gap == Trace::none)
+                          next = (Trace)((this->_directions[word] >> shift) & 3);
+                      if (next == Trace::none)
+                          return Trace::none;
+                      unsigned extends = affine ? (this->_extensions[word] >> shift) & 3 : 0;
+                      bool extending = (next == Trace::up && (extends & Node::_vertical))
+                          || (next == Trace::left && (extends & Node::_horizontal));
+                      gap = extending ? next : Trace::none;
+                      return next;
+                  };
+                  auto mask = [&] (int i, int j) {
+                      for (int column : { j, this->twin (j) })
+                          if (column != Node::_undefined && (i != maxNodeI || column != maxNodeJ))
+                              this->_matchedBits[i * stride + (column >> 6)] |= (uint64_t)1 << (column & 63);
+                  };
+                  this->traceback (maxNodeI, maxNodeJ, maxNodeValue, trace, mask);
+                  hitCount++;
+              }
+              return this->_matches;
+          }
+
+          /**
+           * searchThreshold()
+           *
+           * @brief
+           * Search every match that reaches the minimum score with one fill of the matrix,
+           * which keeps two bits of trace per node like the compact memory mode. Below the
+           * rows in which a match can still begin only nodes next to a node that can reach
+           * the minimum are scored. Every node reaching the minimum with an aligned pair ends
+           * a candidate, the candidates are traced back in order of their score and then
+           * their position and matches overlapping an earlier one in the haystack are
+           * dropped. Unlike the search for a fixed amount, matches beside a better one are
+           * not realigned around it.
+           */
+          std::list<Match<Tp>>&
+          searchThreshold ()
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const int64_t width = lastJ + 1;
+              const size_t pairs = (lastJ >> 5) + 1;
+              const bool affine = this->_scoreSet._gapOpen != 0;
+              const int threshold = this->threshold ();
+              const int best = this->_scoreSet._highest;
+              const int rows = this->bandRows (lastI);
+              if (threshold <= 0)
+                  throw std::invalid_argument ("All matches need a minimum score, edits or an E-value");
+
+              std::vector<int> previous, current, vertical;
+              std::vector<char> above, reaches;
+              std::vector<std::pair<int, int64_t>> candidates;
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::initialize);
+                  const size_t capacities[] = { this->_directions.capacity (),
+                      this->_extensions.capacity () };
+                  this->_directions.resize ((size_t)(lastI + 1) * pairs);
+                  if (affine)
+                      this->_extensions.resize (this->_directions.size ());
+                  previous.assign (lastJ + 1, 0);
+                  current.assign (lastJ + 1, 0);
+                  vertical.assign (lastJ + 1, detail::GapScores::_closed);
+                  above.assign (lastJ + 1, 0);
+                  reaches.assign (lastJ + 1, 0);
+                  if constexpr (QueryStats::enabled)
+                  {
+                      this->_stats.grew (capacities[0], this->_directions);
+                      this->_stats.grew (capacities[1], this->_extensions);
+                      for (const std::vector<int>* row : { &previous, &current, &vertical })
+                          this->_stats.grew (0, *row);
+                  }
+              }
+
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::update);
+                  uint64_t scored = 0;
+                  for (int i = 1; i <= lastI; ++i)
+                  {
+                      const int16_t* scores = this->_scoreSet.row (this->needleAt (i - 1));
+                      uint64_t* directions = this->_directions.data () + i * pairs;
+                      uint64_t* extensions = affine ? this->_extensions.data () + i * pairs : nullptr;
+                      const bool pruned = i > rows;
+                      this->kernel (i == lastI, [&] (auto gaps, auto lastRow) {
+                          using TGaps = decltype (gaps);
+                          constexpr bool last = decltype (lastRow)::value;
+                          uint64_t directionWord = 0;
+                          uint64_t extensionWord = 0;
+                          int horizontal = detail::GapScores::_closed;
+                          bool left = false;
+                          current[0] = 0;
+                          auto node = [&] (int j, auto lastColumn) {
+                              /* A node that can reach the minimum reaches the node below and
+                               * the diagonal one, and the next node of its row. Other nodes
+                               * keep a score of zero and closed gaps, which never changes the
+                               * score or trace of a node that can reach the minimum. */
+                              unsigned char extends = 0;
+                              Trace trace = Trace::none;
+                              if (pruned && !left && !above[j] && !above[j - 1])
+                              {
+                                  current[j] = 0;
+                                  vertical[j] = detail::GapScores::_closed;
+                                  horizontal = detail::GapScores::_closed;
+                              }
+                              else
+                              {
+                                  int substitution = scores[(unsigned char)this->_haystack->characters[j - 1]];
+                                  current[j] = this->cell<detail::HybridAlignment, TGaps, last,
+                                      decltype (lastColumn)::value> (
+                                      previous[j], current[j - 1], previous[j - 1], substitution,
+                                      vertical[j], horizontal, extends, trace);
+                                  if (current[j] >= threshold && trace == Trace::diagonal)
+                                      candidates.emplace_back (current[j], -(i * width + j));
+                                  if constexpr (QueryStats::enabled)
+                                      ++scored;
+                              }
+                              left = current[j] + (lastI - i) * best >= threshold;
+                              reaches[j] = left;
+                              directionWord |= (uint64_t)trace << ((j & 31) * 2);
+                              if constexpr (TGaps::affine)
+                                  extensionWord |= (uint64_t)extends << ((j & 31) * 2);
+                              if ((j & 31) == 31 || decltype (lastColumn)::value)
+                              {
+                                  directions[j >> 5] = directionWord;
+                                  directionWord = 0;
+                                  if constexpr (TGaps::affine)
+                                  {
+                                      extensions[j >> 5] = extensionWord;
+                                      extensionWord = 0;
+                                  }
+                              }
+                          };
+                          for (int j = 1; j < lastJ; ++j)
+                              node (j, std::false_type ());
+                          if (lastJ > 0)
+                              node (lastJ, std::true_type ());
+                      });
+                      previous.swap (current);
+                      above.swap (reaches);
+                  }
+                  if constexpr (QueryStats::enabled)
+                  {
+                      this->_stats._cellsComputed += scored;
+                      this->_stats._cellsSkipped += (uint64_t)lastI * lastJ - scored;
+                      this->_stats.grew (0, candidates);
+                  }
+              }
+
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::scan);
+                  std::sort (candidates.begin (), candidates.end (), std::greater<> ());
+              }
+
+              this->traceCandidates (candidates, false);
+              return this->_matches;
+          }
+
+          /**
+           * searchAligned(), sweepAligned()
+           *
+           * @brief
+           * Search with an alignment mode other than hybrid in one fill of the matrix with
+           * two bits of trace per node, by a kernel generated for the mode and the gap model.
+           * The first row and column are set up before the fill and the ends of matches are
+           * read from the last row and column after it, so no node compares its position.
+           * Local matches end at any node with an aligned pair, the others where their mode
+           * allows it, and the ends are traced back like in the threshold search. Matches
+           * other than local ones reach a positive score, except for a global match which is
+           * reported whatever its score unless it misses a minimum score.
+           */
+          std::list<Match<Tp>>&
+          searchAligned ()
+          {
+              switch (this->_alignmentMode)
+              {
+                  case AlignmentMode::local:
+                      return this->sweepAligned<detail::LocalAlignment> ();
+                  case AlignmentMode::global:
+                      return this->sweepAligned<detail::GlobalAlignment> ();
+                  case AlignmentMode::semiGlobal:
+                      return this->sweepAligned<detail::SemiGlobalAlignment> ();
+                  default:
+                      return this->sweepAligned<detail::OverlapAlignment> ();
+              }
+          }
+          template <typename TMode>
+          std::list<Match<Tp>>&
+          sweepAligned ()
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const int64_t width = lastJ + 1;
+              const size_t pairs = (lastJ >> 5) + 1;
+              const bool affine = this->_scoreSet._gapOpen != 0;
+              const int threshold = this->threshold ();
+              if (lastI == 0 || lastJ == 0)
+                  return this->_matches;
+
+              /* Gaps along the first row and column cost their length unless they are free */
+              auto border = [this] (int length) {
+                  return length == 0 ? 0 : -(this->_scoreSet._gapOpen + length * this->_scoreSet._gap);
+              };
+              auto at = [this, pairs] (int i, int j) {
+                  return (Trace)((this->_directions[i * pairs + (j >> 5)] >> ((j & 31) * 2)) & 3);
+              };
+              auto end = [threshold] (int value) {
+                  return value > 0 && value >= threshold;
+              };
+
+              std::vector<int> previous, current, vertical;
+              std::vector<std::pair<int, int64_t>> candidates;
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::initialize);
+                  const size_t capacities[] = { this->_directions.capacity (),
+                      this->_extensions.capacity () };
+                  this->_directions.resize ((size_t)(lastI + 1) * pairs);
+                  std::fill_n (this->_directions.begin (), pairs, 0);
+                  if (affine)
+                  {
+                      this->_extensions.resize (this->_directions.size ());
+                      std::fill_n (this->_extensions.begin (), pairs, 0);
+                  }
+                  previous.resize (lastJ + 1);
+                  current.resize (lastJ + 1);
+                  vertical.assign (lastJ + 1, detail::GapScores::_closed);
+                  for (int j = 0; j <= lastJ; ++j)
+                  {
+                      previous[j] = TMode::freeRow ? 0 : border (j);
+                      if (TMode::freeRow || j == 0)
+                          continue;
+                      this->_directions[j >> 5] |= (uint64_t)Trace::left << ((j & 31) * 2);
+                      if (affine && j > 1)
+                          this->_extensions[j >> 5] |= (uint64_t)Node::_horizontal << ((j & 31) * 2);
+                  }
+                  if constexpr (QueryStats::enabled)
+                  {
+                      this->_stats.grew (capacities[0], this->_directions);
+                      this->_stats.grew (capacities[1], this->_extensions);
+                      for (const std::vector<int>* row : { &previous, &current, &vertical })
+                          this->_stats.grew (0, *row);
+                  }
+              }
+
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::update);
+                  for (int i = 1; i <= lastI; ++i)
+                  {
+                      const int16_t* scores = this->_scoreSet.row (this->needleAt (i - 1));
+                      uint64_t* directions = this->_directions.data () + i * pairs;
+                      uint64_t* extensions = affine ? this->_extensions.data () + i * pairs : nullptr;
+                      this->kernel (false, [&] (auto gaps, auto) {
+                          using TGaps = decltype (gaps);
+                          uint64_t directionWord = TMode::freeColumn ? 0 : (uint64_t)Trace::up;
+                          uint64_t extensionWord = TMode::freeColumn || i == 1 ? 0 : Node::_vertical;
+                          int horizontal = detail::GapScores::_closed;
+                          current[0] = TMode::freeColumn ? 0 : border (i);
+                          for (int j = 1; j <= lastJ; ++j)
+                          {
+                              int substitution = scores[(unsigned char)this->_haystack->characters[j - 1]];
+                              unsigned char extends = 0;
+                              Trace trace;
+                              current[j] = this->cell<TMode, TGaps, false, false> (previous[j],
+                                  current[j - 1], previous[j - 1], substitution, vertical[j],
+                                  horizontal, extends, trace);
+                              if constexpr (TMode::clamped)
+                                  if (end (current[j]) && trace == Trace::diagonal)
+                                      candidates.emplace_back (current[j], -(i * width + j));
+                              directionWord |= (uint64_t)trace << ((j & 31) * 2);
+                              if constexpr (TGaps::affine)
+                                  extensionWord |= (uint64_t)extends << ((j & 31) * 2);
+                              if ((j & 31) == 31)
+                              {
+                                  directions[j >> 5] = directionWord;
+                                  directionWord = 0;
+                                  if constexpr (TGaps::affine)
+                                  {
+                                      extensions[j >> 5] = extensionWord;
+                                      extensionWord = 0;
+                                  }
+                              }
+                          }
+                          if ((lastJ & 31) != 31)
+                          {
+                              directions[lastJ >> 5] = directionWord;
+                              if constexpr (TGaps::affine)
+                                  extensions[lastJ >> 5] = extensionWord;
+                          }
+                      });
+
+                      /* Matches end in the last column before the needle does */
+                      if constexpr (TMode::endColumn)
+                          if (i < lastI && end (current[lastJ]) && at (i, lastJ) != Trace::up)
+                              candidates.emplace_back (current[lastJ], -(i * width + lastJ));
+                      previous.swap (current);
+                  }
+                  if constexpr (QueryStats::enabled)
+                      this->_stats._cellsComputed += (uint64_t)lastI * lastJ;
+              }
+
+              /* Matches end in the last row, or global ones in the last node */
+              if constexpr (TMode::endRow)
+              {
+                  for (int j = 1; j <= lastJ; ++j)
+                      if (end (previous[j]) && at (lastI, j) != Trace::left)
+                          candidates.emplace_back (previous[j], -(lastI * width + j));
+              }
+              else if constexpr (!TMode::clamped && !TMode::endColumn)
+              {
+                  if (threshold <= 0 || previous[lastJ] >= threshold)
+                      candidates.emplace_back (previous[lastJ], -(lastI * width + lastJ));
+              }
+
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::scan);
+                  std::sort (candidates.begin (), candidates.end (), std::greater<> ());
+              }
+              if constexpr (QueryStats::enabled)
+                  this->_stats.grew (0, candidates);
+              this->traceCandidates (candidates, !TMode::clamped);
+              return this->_matches;
+          }
+
+          /**
+           * traceCandidates()
+           *
+           * @brief
+           * Trace back the end nodes of matches from two bits of trace per node, in order of
+           * their score and then their position, until the amount of matches. Ends inside an
+           * earlier match are not traced back and matches that overlap an earlier one in the
+           * haystack are dropped.
+           * @param candidates The scores and negated positions of the end nodes, in order.
+           * @param whole Whether the matches are whole paths, see traceback().
+           */
+          void
+          traceCandidates (const std::vector<std::pair<int, int64_t>>& candidates, bool whole)
+          {
+              const int64_t width = this->columns () + 1;
+              const size_t pairs = (this->columns () >> 5) + 1;
+              const bool affine = this->_scoreSet._gapOpen != 0;
+              std::map<int64_t, int64_t> found;
+              int hitCount = 0;
+              for (const std::pair<int, int64_t>& candidate : candidates)
+              {
+                  if (hitCount == this->_amount)
+                      break;
+                  int maxNodeI = -candidate.second / width;
+                  int maxNodeJ = -candidate.second % width;
+
+                  /* Ends inside an earlier match are not traced back */
+                  size_t end = this->column (maxNodeJ);
+                  if (this->overlaps (found, end, end))
+                      continue;
+
+                  /* A gap that extends the gap of its neighbour continues there */
+                  Trace gap = Trace::none;
+                  auto trace = [&] (int i, int j) {
+                      if (!whole && (i == 0 || j == 0))
+                          return Trace::none;
+                      size_t word = i * pairs + (j >> 5);
+                      int shift = (j & 31) * 2;
+                      Trace next = gap;
+                      if (gap == Trace::none)
+                          next = (Trace)((this->_directions[word] >> shift) & 3);
+                      if (next == Trace::none)
+                          return Trace::none;
+                      unsigned extends = affine ? (this->_extensions[word] >> shift) & 3 : 0;
+                      bool extending = (next == Trace::up && (extends & Node::_vertical))
+                          || (next == Trace::left && (extends & Node::_horizontal));
+                      gap = extending ? next : Trace::none;
+                      return next;
+                  };
+                  this->traceback (maxNodeI, maxNodeJ, candidate.first, trace, [] (int, int) {}, whole);
+                  const Item<Tp>& haystack = this->_matches.back ()._haystack;
+                  if (!this->claim (found, haystack._start, haystack._end))
+                  {
+                      this->_matches.pop_back ();
+                      continue;
+                  }
+                  hitCount++;
+              }
+          }
+
+          /**
+           * searchVector()
+           *
+           * @brief
+           * Search with the vector engine, the matrix only keeps the scores of the nodes
+           * in lanes as narrow as possible and traces are derived from the scores.
+           */
+          std::list<Match<Tp>>&
+          searchVector ()
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const size_t stride = (lastJ >> 6) + 1;
+              if (this->_matchedBits.empty ())
+              {
+                  this->_matchedBits.assign ((lastI + 1) * stride, 0);
+                  if constexpr (QueryStats::enabled)
+                      this->_stats.grew (0, this->_matchedBits);
+              }
+
+              int hitCount = 0;
+              while (hitCount < this->_amount)
+              {
+                  int maxNodeValue = 0;
+                  int maxNodeI = Node::_undefined;
+                  int maxNodeJ = Node::_undefined;
+                  bool saturated = true;
+                  while (saturated)
+                  {
+                      switch (this->_laneBytes)
+                      {
+                          case 1:
+                              saturated = this->fillVector<int8_t> (maxNodeValue, maxNodeI, maxNodeJ);
+                              break;
+                          case 2:
+                              saturated = this->fillVector<int16_t> (maxNodeValue, maxNodeI, maxNodeJ);
+                              break;
+                          default:
+                              saturated = this->fillVector<int32_t> (maxNodeValue, maxNodeI, maxNodeJ);
+                              break;
+                      }
+                      if (saturated)
+                      {
+                          this->_laneBytes *= 2;
+                          this->_scores.clear ();
+                      }
+                  }
+
+                  if (maxNodeValue == 0 || maxNodeValue < this->threshold ())
+                  {
+                      break;
+                  }
+
+                  auto score = [this, lastJ] (int i, int j) {
+                      size_t index = (size_t)i * (lastJ + 1) + j;
+                      switch (this->_laneBytes)
+                      {
+                          case 1: return (int)((const int8_t*)this->_scores.data ())[index];
+                          case 2: return (int)((const int16_t*)this->_scores.data ())[index];
+                          default: return (int)((const int32_t*)this->_scores.data ())[index];
+                      }
+                  };
+                  auto trace = [&] (int i, int j) {
+                      if (i == 0 || j == 0)
+                          return Trace::none;
+                      Trace step;
+                      this->step (i == lastI, j == lastJ, score (i - 1, j), score (i, j - 1),
+                          score (i - 1, j - 1), this->_scoreSet.getScore (
+                              this->_haystack->characters[j - 1], this->needleAt (i - 1)),
+                          (this->_matchedBits[i * stride + (j >> 6)] >> (j & 63)) & 1, step);
+                      return step;
+                  };
+                  auto mask = [&] (int i, int j) {
+                      for (int column : { j, this->twin (j) })
+                          if (column != Node::_undefined && (i != maxNodeI || column != maxNodeJ))
+                              this->_matchedBits[i * stride + (column >> 6)] |= (uint64_t)1 << (column & 63);
+                  };
+                  this->traceback (maxNodeI, maxNodeJ, maxNodeValue, trace, mask);
+                  hitCount++;
+              }
+              return this->_matches;
+          }
+
+          /**
+           * fillVector()
+           *
+           * @brief
+           * Fill all rows of the matrix with lanes of type T and find the first node
+           * with the maximum score in row order.
+           * @return Whether a score saturated the lanes and wider lanes are needed.
+           */
+          template <typename T>
+          bool
+          fillVector (int& maxNodeValue, int& maxNodeI, int& maxNodeJ)
+          {
+              const int lastI = this->_needleSequence.length ();
+              const int lastJ = this->columns ();
+              const size_t stride = (lastJ >> 6) + 1;
+              const int largest = std::max ({ std::abs (this->_scoreSet._highest),
+                  std::abs (this->_scoreSet._lowest), std::abs (this->_scoreSet._gap) });
+              if (sizeof (T) < sizeof (int32_t) && 2 * largest >= std::numeric_limits<T>::max ())
+                  return true;
+
+              /* One profile for every distinct needle character */
+              std::vector<std::vector<T>> profiles (256);
+              auto profile = [&] (char needle) {
+                  std::vector<T>& scores = profiles[(unsigned char)needle];
+                  if (scores.empty ())
+                  {
+                      const int16_t* row = this->_scoreSet.row (needle);
+                      scores.resize (lastJ);
+                      for (int j = 0; j < lastJ; ++j)
+                          scores[j] = (T)row[(unsigned char)this->_haystack->characters[j]];
+                  }
+                  return scores.data ();
+              };
+
+              if (this->_scores.size () != (size_t)(lastI + 1) * (lastJ + 1) * sizeof (T))
+              {
+                  detail::PhaseTimer timer (this->_stats, QueryStats::initialize);
+                  size_t capacity = this->_scores.capacity ();
+                  this->_scores.assign ((size_t)(lastI + 1) * (lastJ + 1) * sizeof (T), 0);
+                  if constexpr (QueryStats::enabled)
+                      this->_stats.grew (capacity, this->_scores);
+              }
+              detail::PhaseTimer timer (this->_stats, QueryStats::update);
+              T* scores = (T*)this->_scores.data ();
+
+              detail::RowKernel<T> row;
+              row.gap = this->_scoreSet._gap;
+              row.saturation = std::numeric_limits<T>::max () - largest;
+              row.lastJ = lastJ;
+
+              T (*fill) (const detail::RowKernel<T>&) = detail::rowFill<T> ();
+              maxNodeValue = 0;
+              for (int i = 1; i <= lastI; ++i)
+              {
+                  row.previous = scores + (size_t)(i - 1) * (lastJ + 1);
+                  row.current = scores + (size_t)i * (lastJ + 1);
+                  row.matched = this->_matchedBits.data () + i * stride;
+                  row.profile = profile (this->needleAt (i - 1));
+                  row.lastRow = i == lastI;
+
+                  int rowMaximum = fill (row);
+                  if constexpr (QueryStats::enabled)
+                      this->_stats._cellsComputed += lastJ;
+                  if (rowMaximum >= row.saturation)
+                      return true;
+                  if (rowMaximum > maxNodeValue)
+                  {
+                      maxNodeValue = rowMaximum;
+                      maxNodeI = i;
+                      maxNodeJ = std::find (row.current + 1, row.current + lastJ + 1, rowMaximum)
+                          - row.current;
+                  }
+              }
+              return false;
+          }
+
+          /**
+           * key(), isMatched()
+           *
+           * @brief
+           * Nodes of earlier matches in linear memory mode are kept as keys sorted by column.
+           */
+          static uint64_t
+          key (int i, int j)
+          {
+              return ((uint64_t)j << 32) | (uint32_t)i;
+          }
+          bool
+          isMatched (int i, int j) const
+          {
+              return std::binary_search (this->_matched.begin (), this->_matched.end (),
+                  FuzzyQuery<Tp>::key (i, j));
+          }
+
+          /**
+           * needleAt()
+           *
+           * @brief
+           * The base of the needle at a position, read through the reverse complement view of
+           * the needle when the query searches the reverse strand.
+           */
+          char
+          needleAt (int i) const
+          {
+              if (this->_reverse)
+                  return ReverseComplement<Tp> (this->_needleSequence)[i];
+              return this->_needleSequence[i];
+          }
+
+          /**
+           * needleSource()
+           *
+           * @brief
+           * The needle shared with the matches that render their aligned sequences from it.
+           */
+          std::shared_ptr<const Tp>
+          needleSource ()
+          {
+              if (!this->_needleSource)
+                  this->_needleSource = std::make_shared<const Tp> (this->_needleSequence);
+              return this->_needleSource;
+          }
+
+          /**
+           * wrap(), columns()
+           *
+           * @brief
+           * The characters repeated after the end of a circular haystack and the columns of
+           * the matrix with them.
+           */
+          int
+          wrap () const
+          {
+              if (!this->_circular)
+                  return 0;
+              return detail::Haystack<Tp>::wrapping (this->_haystack->sequence.length (),
+                  this->_needleSequence.length (), this->_maxEdits);
+          }
+          int
+          columns () const
+          {
+              return this->_haystack->sequence.length () + this->wrap ();
+          }
+
+          /**
+           * column(), twin()
+           *
+           * @brief
+           * The haystack position of a column counted from one, and the other column of the
+           * same position in a circular haystack or an undefined column.
+           */
+          int
+          column (int j) const
+          {
+              const int length = this->_haystack->sequence.length ();
+              return j > length ? j - length : j;
+          }
+          int
+          twin (int j) const
+          {
+              const int length = this->_haystack->sequence.length ();
+              if (!this->_circular || j == 0)
+                  return Node::_undefined;
+              if (j > length)
+                  return j - length;
+              return j + length <= this->columns () ? j + length : Node::_undefined;
+          }
+
+          /**
+           * space()
+           *
+           * @brief
+           * The search space of the statistics of the query, the needle length times the
+           * haystack length of every searched strand.
+           */
+          double
+          space () const
+          {
+              return (double)this->_needleSequence.length () * this->_haystack->sequence.length ()
+                  * (this->_strand == Strand::both ? 2 : 1);
+          }
+
+          Tp _needleSequence;
+          std::shared_ptr<const Tp> _needleSource;
+          std::shared_ptr<const detail::Haystack<Tp>> _haystack;
+          int _score;
+          int _amount;
+          ScoreMatrix _scoreSet;
+          MemoryMode _memoryMode;
+          Engine _engine;
+          AlignmentMode _alignmentMode;
+          unsigned _threads;
+          int _minimumScore;
+          int _maxEdits;
+          double _maximumEValue;
+          int _significantScore;
+          Strand _strand;
+          bool _circular;
+          bool _reverse;
+          Seeding _seeding;
+          std::vector<std::vector<SeedHit>> _seeds;
+          std::vector<std::vector<Node>> _nodes;
+          std::vector<std::vector<detail::GapScores>> _gaps;
+          bool _spanned;
+          std::vector<std::pair<int, int64_t>> _candidates;
+          std::vector<uint64_t> _matched;
+          std::vector<unsigned char> _scores;
+          std::vector<uint64_t> _matchedBits;
+          std::vector<uint64_t> _directions;
+          std::vector<uint64_t> _extensions;
+          int _laneBytes;
+          std::list<Match<Tp>> _matches;
+          std::string (*_parser)(Item<Tp>&);
+          QueryStats _stats;
+          std::function<void (const QueryStats&)> _statsHook;
+    };
+
+    /**
+     * FuzzyBatchQuery
+     *
+     * @brief
+     * Class template that searches many needles in one haystack, the haystack is prepared
+     * once and shared by all queries while the needles are spread over threads.
+     */
+    template <typename Tp>
+    class FuzzyBatchQuery
+    {
+      public:
+        FuzzyBatchQuery (Tp haystackSequence, std::vector<Tp> needleSequences)
+            : _haystack (std::make_shared<const detail::Haystack<Tp>> (
+                  std::move (haystackSequence))),
+              _needleSequences (std::move (needleSequences))
+        {
+            this->_parser = nullptr;
+            this->_memoryMode = MemoryMode::matrix;
+            this->_engine = Engine::scalar;
+            this->_alignmentMode = AlignmentMode::hybrid;
+            this->_threads = 1;
+            this->_amount = 0;
+            this->_minimumScore = 0;
+            this->_maxEdits = -1;
+            this->_maximumEValue = 0;
+            this->_strand = Strand::forward;
+            this->_circular = false;
+        }
+
+        /**
+         * setItemParser(), setMemoryMode(), setEngine(), setAlignmentMode(), setMinimumScore(),
+         * setMaxEdits(), setMaximumEValue(), setStrand(), setCircular(), setSeeding()
+         *
+         * @brief
+         * Configure the query of every needle like a single FuzzyQuery. Seeded queries share
+         * the seed index of the haystack, it is built by the first query that needs it.
+         */
+        void
+        setItemParser (std::string (*parser)(Item<Tp>&))
+        {
+            this->_parser = parser;
+        }
+        void
+        setMemoryMode (MemoryMode mode)
+        {
+            this->_memoryMode = mode;
+        }
+        void
+        setEngine (Engine engine)
+        {
+            this->_engine = engine;
+        }
+        void
+        setAlignmentMode (AlignmentMode mode)
+        {
+            this->_alignmentMode = mode;
+        }
+        void
+        setMinimumScore (int score)
+        {
+            this->_minimumScore = score;
+        }
+        void
+        setMaxEdits (int edits)
+        {
+            this->_maxEdits = edits;
+        }
+        void
+        setMaximumEValue (double eValue)
+        {
+            this->_maximumEValue = eValue;
+        }
+        void
+        setStrand (Strand strand)
+        {
+            this->_strand = strand;
+        }
+        void
+        setCircular (bool circular)
+        {
+            this->_circular = circular;
+        }
+        void
+        setSeeding (Seeding seeding)
+        {
+            this->_seeding = seeding;
         }
 
         /**
-         * needle()
+         * setThreads()
          *
          * @brief
-         * Get part of the needle sequence that was matched with the haystack.
-         * @return String representation of the match.
+         * Set the amount of threads that take needles from the batch, every needle is
+         * searched by one thread.
+         * @param threads The amount of threads, zero uses all hardware threads.
          */
-        std::string
-        needle ()
+        void
+        setThreads (unsigned threads)
         {
-            if (this->_parser)
-            {
-                return this->_parser(this->_needle);
-            }
-            else
-            {
-                return this->_needle._sequence.toString () + ' ' +
-                    "from " + std::to_string(this->_needle._start) + " to "
-                    + std::to_string(this->_needle._end);
-            }
+            this->_threads = threads != 0 ? threads
+                : std::max (1u, std::thread::hardware_concurrency ());
         }
 
         /**
-         * score()
+         * initializeScoreMatrix()
          *
          * @brief
-         * Get the calculated score for the match.
+         * Set rewards and penalties for score calculation as well as amounts.
+         * @param scoreSet The values used to calculate scores for sequence parts.
+         * @param amount The amount of matches to be retrieved for every needle.
          */
-        std::string
-        score()
-        {
-            std::string res = "Score ";
-            res += std::to_string(this->_score);
-            return res;
-        }
-
-        int _score;
-        Item<Tp> _haystack;
-        Item<Tp> _needle;
-        std::string (*_parser)(Item<Tp>&);
-    };
-
-    /**
-     * ScoreMatrix
-     *
-     * @brief
-     * Class that describes how fuzzy scores are calculated when comparing two sequence characters.
-     */
-    class ScoreMatrix
-    {
-      public:
-        ScoreMatrix () = default;
-        ScoreMatrix (const ScoreMatrix& other)
-        {
-            this->_match = other._match;
-            this->_mismatch = other._mismatch;
-            this->_gap = other._gap;
-        }
-        ScoreMatrix (int match, int mismatch, int gap)
+        void
+        initializeScoreMatrix (ScoreMatrix scoreSet, int amount)
         {
-            this->_match = match;
-            this->_mismatch = mismatch;
-            this->_gap = gap;
+            this->_scoreSet = scoreSet;
+            this->_amount = amount;
         }
 
         /**
-         * getScore()
+         * search()
          *
          * @brief
-         * Calculate the score for two characters from the haystack and needle.
-         * @param r1 Character from haystack.
-         * @param r2 Character from needle.
+         * Get the matches of every needle in the order of the needles.
          */
-        int
-        getScore (char r1, char r2)
+        std::vector<std::list<Match<Tp>>>&
+        search ()
         {
-            if (!(tolower (r1) - tolower (r2)))
-            {
-                return this->_match;
-            }
-            else
+            this->_matches.assign (this->_needleSequences.size (), std::list<Match<Tp>> ());
+            this->_seeds.assign (this->_needleSequences.size (), std::vector<std::vector<SeedHit>> ());
+            if (this->_needleSequences.empty ())
+                return this->_matches;
+
+            /* A circular haystack repeats enough characters for the longest needle before
+             * the threads share it */
+            if (this->_circular)
             {
-                return this->_mismatch;
+                size_t longest = 0;
+                for (const Tp& needle : this->_needleSequences)
+                    longest = std::max (longest, (size_t)needle.length ());
+                size_t wrap = detail::Haystack<Tp>::wrapping (this->_haystack->sequence.length (),
+                    longest, this->_maxEdits);
+                if (this->_haystack->characters.size () < this->_haystack->sequence.length () + wrap)
+                    this->_haystack = std::make_shared<const detail::Haystack<Tp>> (
+                        this->_haystack->sequence, wrap);
             }
-        }
 
-        int _match;
-        int _mismatch;
-        int _gap;
-    };
+            /* Every thread reuses one query and with it the nodes of its matrix */
+            std::atomic<size_t> next = 0;
+            auto work = [this, &next] () {
+                std::unique_ptr<FuzzyQuery<Tp>> query;
+                for (size_t k = next++; k < this->_needleSequences.size (); k = next++)
+                {
+                    if (!query)
+                        query.reset (new FuzzyQuery<Tp> (this->_haystack, this->_needleSequences[k]));
+                    else
+                        query->initializeMatrix (this->_haystack, this->_needleSequences[k]);
+                    query->setItemParser (this->_parser);
+                    query->setMemoryMode (this->_memoryMode);
+                    query->setEngine (this->_engine);
+                    query->setAlignmentMode (this->_alignmentMode);
+                    query->setMinimumScore (this->_minimumScore);
+                    query->setMaxEdits (this->_maxEdits);
+                    query->setMaximumEValue (this->_maximumEValue);
+                    query->setStrand (this->_strand);
+                    query->setCircular (this->_circular);
+                    query->setSeeding (this->_seeding);
+                    query->initializeScoreMatrix (this->_scoreSet, this->_amount);
+                    this->_matches[k].splice (this->_matches[k].end (), query->search ());
+                    this->_seeds[k].swap (query->_seeds);
+                    query->_seeds.clear ();
+                }
+            };
 
-    /**
-     * Node
-     *
-     * @brief
-     * Class that describes one node unit to span the haystack*needle matrix,
-     * it stores the calculated fuzzy score and position.
-     */
-    class Node
-    {
-      public:
-        Node () : _value (Node::_undefined),
-                  _tracebackI (Node::_undefined),
-                  _tracebackJ (Node::_undefined) {}
+            unsigned workers = std::min<size_t> (this->_threads, this->_needleSequences.size ());
+            std::vector<std::thread> threads;
+            for (unsigned worker = 1; worker < workers; worker++)
+                threads.emplace_back (work);
+            work ();
+            for (std::thread& thread : threads)
+                thread.join ();
+            return this->_matches;
+        }
 
-        int _value;
-        int _tracebackI;
-        int _tracebackJ;
-        bool _alreadyMatched = false;
-        static const int _undefined = std::numeric_limits<int>::max();
+        /**
+         * seeds()
+         *
+         * @brief
+         * Get the seeds that led to every match of a seeded search, in the order of the
+         * needles and of their matches.
+         */
+        std::vector<std::vector<std::vector<SeedHit>>>&
+        seeds ()
+        {
+            return this->_seeds;
+        }
+
+        private:
+          std::shared_ptr<const detail::Haystack<Tp>> _haystack;
+          std::vector<Tp> _needleSequences;
+          ScoreMatrix _scoreSet;
+          int _amount;
+          MemoryMode _memoryMode;
+          Engine _engine;
+          AlignmentMode _alignmentMode;
+          unsigned _threads;
+          int _minimumScore;
+          int _maxEdits;
+          double _maximumEValue;
+          Strand _strand;
+          bool _circular;
+          Seeding _seeding;
+          std::vector<std::list<Match<Tp>>> _matches;
+          std::vector<std::vector<std::vector<SeedHit>>> _seeds;
+          std::string (*_parser)(Item<Tp>&);
     };
 
     /**
-     * FuzzyQuery
+     * FuzzyStreamQuery
      *
      * @brief
-     * Class template fuzzy search algorithm calculates a fuzzy score for all nodes in matrix
-     * and returns matching parts of the haystack sequence according to their score.
+     * Class template that searches a needle in a haystack arriving in pieces, for example from
+     * a SequenceReader. The haystack is searched in chunks that overlap by twice the needle length
+     * and the allowed edits. Every chunk reports the matches that end behind those reported by the
+     * chunk before, except for those ending in its last needle length and edits, which the next
+     * chunk finds whole. Matches are passed to a callback as soon as their chunk was searched, so
+     * memory is bounded by the chunk size and not by the haystack.
      */
     template <typename Tp>
-    class FuzzyQuery
+    class FuzzyStreamQuery
     {
       public:
-        FuzzyQuery(Tp haystackSequence, Tp needleSequence)
+        FuzzyStreamQuery (Tp needleSequence, size_t chunk, std::function<void (Match<Tp>&)> emit)
+            : FuzzyStreamQuery (std::move (needleSequence), chunk,
+                  [emit] (Match<Tp>& match, std::vector<SeedHit>&) { emit (match); }) {}
+
+        /**
+         * FuzzyStreamQuery()
+         *
+         * @brief
+         * Pass the seeds that led to every match of a seeded search to the callback along
+         * with the match, their haystack positions count from the start of the haystack.
+         */
+        FuzzyStreamQuery (Tp needleSequence, size_t chunk,
+                          std::function<void (Match<Tp>&, std::vector<SeedHit>&)> emit)
+            : _needleSequence (std::move (needleSequence)), _chunk (std::max<size_t> (chunk, 1)), _emit (emit)
         {
-            this->initializeMatrix(haystackSequence, needleSequence);
             this->_parser = nullptr;
+            this->_memoryMode = MemoryMode::matrix;
+            this->_engine = Engine::scalar;
+            this->_threads = 1;
+            this->_amount = 0;
+            this->_minimumScore = 0;
+            this->_maxEdits = -1;
+            this->_strand = Strand::forward;
+            this->_offset = 0;
+            this->_carried = 0;
+            this->_reported = 0;
         }
 
         /**
-         * setItemParser()
+         * setItemParser(), setMemoryMode(), setEngine(), setThreads(), setMinimumScore(),
+         * setMaxEdits(), setStrand(), setSeeding()
          *
          * @brief
-         * Set parser for a single item from a match.
-         * @param parser The function used for parsing part of a sequence with start and end.
+         * Configure the query of every chunk like a single FuzzyQuery.
          */
         void
-        setItemParser(std::string (*parser)(Item<Tp>&))
+        setItemParser (std::string (*parser)(Item<Tp>&))
         {
             this->_parser = parser;
         }
+        void
+        setMemoryMode (MemoryMode mode)
+        {
+            this->_memoryMode = mode;
+        }
+        void
+        setEngine (Engine engine)
+        {
+            this->_engine = engine;
+        }
+        void
+        setThreads (unsigned threads)
+        {
+            this->_threads = threads;
+        }
+        void
+        setMinimumScore (int score)
+        {
+            this->_minimumScore = score;
+        }
+        void
+        setMaxEdits (int edits)
+        {
+            this->_maxEdits = edits;
+        }
+        void
+        setStrand (Strand strand)
+        {
+            this->_strand = strand;
+        }
+        void
+        setSeeding (Seeding seeding)
+        {
+            this->_seeding = seeding;
+        }
 
         /**
          * initializeScoreMatrix()
@@ -682,7 +5570,7 @@ namespace sqn
          * @brief
          * Set rewards and penalties for score calculation as well as amounts.
          * @param scoreSet The values used to calculate scores for sequence parts.
-         * @param amount The amount of matches to be retrieved.
+         * @param amount The amount of matches to be retrieved from every chunk.
          */
         void
         initializeScoreMatrix (ScoreMatrix scoreSet, int amount)
@@ -692,252 +5580,188 @@ namespace sqn
         }
 
         /**
-         * initializeMatrix()
+         * append()
          *
          * @brief
-         * Span the matrix of haystack*needle dimensions and set undefined states.
-         * @param haystackSequence The complete genome to be searched.
-         * @param needleSequence The needle sequence to be approximately searched.
+         * Append bases to the haystack, every chunk is searched as soon as it is complete.
+         * @param bases, count The first base and the amount of bases, or a range of bases.
          */
         void
-        initializeMatrix (Tp haystackSequence, Tp needleSequence)
+        append (const char* bases, size_t count)
         {
-            this->_haystackSequence = haystackSequence;
-            this->_needleSequence = needleSequence;
-            this->_score = 0;
-
-            std::vector<std::vector<Node>> nodes (
-                needleSequence.length () + 1,
-                std::vector<Node> (haystackSequence.length () + 1, Node ()));
-
-            nodes[0][0]._value = 0;
-
-            for (int i = 1; i < nodes.size (); i++)
+            while (count > 0)
             {
-                nodes[i][0]._value = nodes[i - 1][0]._value;
-                nodes[i][0]._tracebackI = i - 1;
-                nodes[i][0]._tracebackJ = 0;
+                size_t take = std::min (count, this->_carried + this->_chunk - this->_buffer.size ());
+                this->_buffer.append (bases, take);
+                bases += take;
+                count -= take;
+                if (this->_buffer.size () == this->_carried + this->_chunk)
+                    this->searchChunk (false);
             }
-
-            for (int j = 1; j < nodes[0].size (); j++)
+        }
+        template <typename TRange>
+        void
+        append (const TRange& bases)
+        {
+            char buffer[1 << 12];
+            size_t used = 0;
+            for (auto base : bases)
             {
-                nodes[0][j]._value = nodes[0][j - 1]._value;
-                nodes[0][j]._tracebackI = 0;
-                nodes[0][j]._tracebackJ = j - 1;
+                buffer[used++] = (char)base;
+                if (used == sizeof (buffer))
+                {
+                    this->append (buffer, used);
+                    used = 0;
+                }
             }
-
-            this->_nodes = nodes;
+            if (used > 0)
+                this->append (buffer, used);
         }
 
         /**
-         * updateMatrix()
+         * finish()
          *
          * @brief
-         * Update all nodes in the matrix.
+         * Search the bases behind the last complete chunk at the end of the haystack, the
+         * next bases start a new haystack.
          */
         void
-        updateMatrix ()
+        finish ()
         {
-            for (int i = 1; i < this->_nodes.size (); i++)
-            {
-                for (int j = 1; j < this->_nodes[0].size (); j++)
-                {
-                    int a, b, c;
-
-                    if (this->_nodes[i][j]._alreadyMatched)
-                    {
-                        a = 0;
-                        b = 0;
-                        c = 0;
-                    }
-                    else if (i == (this->_nodes.size () - 1)
-                        && j == (this->_nodes[0].size () - 1))
-                    {
-                        a = this->_nodes[i - 1][j]._value;
-                        b = this->_nodes[i][j - 1]._value;
-                        c = this->_nodes[i - 1][j - 1]._value
-                            + this->_scoreSet.getScore (this->_needleSequence[i - 1],
-                            this->_haystackSequence[j - 1]);
-                    }
-                    else if (i == (this->_nodes.size () - 1))
-                    {
-                        a = this->_nodes[i - 1][j]._value
-                            - this->_scoreSet._gap;
-                        b = this->_nodes[i][j - 1]._value;
-                        c = this->_nodes[i - 1][j - 1]._value
-                            + this->_scoreSet.getScore (this->_needleSequence[i - 1],
-                            this->_haystackSequence[j - 1]);
-                    }
-                    else if (j == (this->_nodes[0].size () - 1))
-                    {
-                        a = this->_nodes[i - 1][j]._value;
-                        b = this->_nodes[i][j - 1]._value
-                            - this->_scoreSet._gap;
-                        c = this->_nodes[i - 1][j - 1]._value
-                            + this->_scoreSet.getScore (this->_needleSequence[i - 1],
-                            this->_haystackSequence[j - 1]);
-                    }
-                    else
-                    {
-                        a = this->_nodes[i - 1][j]._value
-                            - this->_scoreSet._gap;
-                        b = this->_nodes[i][j - 1]._value
-                            - this->_scoreSet._gap;
-                        c = this->_nodes[i - 1][j - 1]._value
-                            + this->_scoreSet.getScore (this->_needleSequence[i - 1],
-                            this->_haystackSequence[j - 1]);
-                    }
-
-                    if ((a > b) && (a > c))
-                    {
-                        this->_nodes[i][j]._value = a;
-                        this->_nodes[i][j]._tracebackI = i - 1;
-                        this->_nodes[i][j]._tracebackJ = j;
-                    }
-                    else if ((b > c) && (b > a))
-                    {
-                        this->_nodes[i][j]._value = b;
-                        this->_nodes[i][j]._tracebackI = i;
-                        this->_nodes[i][j]._tracebackJ = j - 1;
-                    }
-                    else
-                    {
-                        this->_nodes[i][j]._value = c;
-                        this->_nodes[i][j]._tracebackI = i - 1;
-                        this->_nodes[i][j]._tracebackJ = j - 1;
-                    }
-                    if (this->_nodes[i][j]._value < 0)
-                    {
-                        this->_nodes[i][j]._value = 0;
-                        this->_nodes[i][j]._tracebackI = Node::_undefined;
-                        this->_nodes[i][j]._tracebackJ = Node::_undefined;
-                    }
-
-                }
-            }
-
-            this->_score
-                = this->_nodes[this->_nodes.size () - 1][this->_nodes[0].size () - 1]
-                ._value;
+            if (this->_buffer.size () > this->_reported)
+                this->searchChunk (true);
+            this->_buffer.clear ();
+            this->_offset = 0;
+            this->_carried = 0;
+            this->_reported = 0;
         }
 
+      private:
         /**
-         * search()
+         * searchChunk()
          *
          * @brief
-         * Get aligned haystack sequence and needle sequence matches according to amount.
+         * Search the buffered chunk and report the matches that end behind those reported
+         * by the chunk before. Matches that end in the last needle length and edits of a
+         * chunk that is not the last one are left to the next chunk, which carries twice as
+         * many bases so that it finds them whole. Matches that are left out do not count
+         * towards the amount, the chunk is searched for twice as many until enough are
+         * reported or there are no more.
+         * @param last Whether the chunk ends the haystack.
          */
-        std::list<Match<Tp>>&
-        search ()
+        void
+        searchChunk (bool last)
         {
-            int hitCount = 0;
-            while (hitCount < this->_amount)
-            {
-                this->updateMatrix ();
-                int maxNodeValue = 0;
-                int maxNodeI = Node::_undefined;
-                int maxNodeJ = Node::_undefined;
+            const size_t needle = this->_needleSequence.length ();
+            const size_t overlap = needle + (this->_maxEdits >= 0 ? (size_t)this->_maxEdits : needle);
+            const size_t end = last ? this->_buffer.size ()
+                : this->_buffer.size () - std::min (this->_buffer.size (), overlap);
+            auto reported = [this, end] (const Match<Tp>& match) {
+                return match._haystack._end != (size_t)Node::_undefined
+                    && match._haystack._end > this->_reported && match._haystack._end <= end;
+            };
 
-                for (int i = 1; i < this->_nodes.size (); i++)
-                {
-                    for (int j = 1; j < this->_nodes[0].size (); j++)
-                    {
-                        if (this->_nodes[i][j]._value > maxNodeValue)
-                        {
-                            maxNodeValue = this->_nodes[i][j]._value;
-                            maxNodeI = i;
-                            maxNodeJ = j;
-                        }
-                    }
-                }
+            const Tp haystack (this->_buffer);
+            std::list<Match<Tp>> matches;
+            std::vector<std::vector<SeedHit>> seeds;
+            for (int requested = this->_amount;;)
+            {
+                FuzzyQuery<Tp> query (haystack, this->_needleSequence);
+                query.initializeScoreMatrix (this->_scoreSet, requested);
+                query.setItemParser (this->_parser);
+                query.setMemoryMode (this->_memoryMode);
+                query.setEngine (this->_engine);
+                query.setThreads (this->_threads);
+                query.setMinimumScore (this->_minimumScore);
+                query.setMaxEdits (this->_maxEdits);
+                query.setStrand (this->_strand);
+                query.setSeeding (this->_seeding);
+                matches = std::move (query.search ());
+                seeds = std::move (query.seeds ());
 
-                if (maxNodeValue == 0)
-                {
+                /* The amount asked for doubles so that all searches together cost at most
+                 * twice the last one, a search that ran out of matches or repeats its last
+                 * match has no more to offer */
+                const int kept = std::count_if (matches.begin (), matches.end (), reported);
+                if (kept >= this->_amount || (int)matches.size () < requested
+                    || requested > allMatches / 4 || this->repeats (matches))
                     break;
-                }
-
-                int currentI = maxNodeI;
-                int currentJ = maxNodeJ;
-                Node &currentNode = this->_nodes[maxNodeI][maxNodeJ];
-
-                Tp alignedNeedle;
-                Tp alignedHaystack;
-                int score = currentNode._value;
-                int endNeedle = Node::_undefined;
-                int endHaystack = Node::_undefined;
-
-                while (currentNode._tracebackI != Node::_undefined
-                    && currentNode._tracebackJ != Node::_undefined)
-                {
-                    if (currentI == 0 || currentJ == 0)
-                    {
-                        break;
-                    }
-
-                    if (currentNode._tracebackI == currentI - 1
-                        && currentNode._tracebackJ == currentJ - 1)
-                    {
-                        if (endNeedle == Node::_undefined)
-                        {
-                            endNeedle = currentI;
-                            endHaystack = currentJ;
-                        }
-                        alignedNeedle += this->_needleSequence[currentI - 1];
-                        alignedHaystack += this->_haystackSequence[currentJ - 1];
-                    }
-                    else if (currentNode._tracebackJ == currentJ - 1)
-                    {
-                        if (endNeedle != Node::_undefined)
-                        {
-                            alignedNeedle += "-";
-                            alignedHaystack += this->_haystackSequence[currentJ - 1];
-                        }
-                    }
-                    else
-                    {
-                        if (endNeedle != Node::_undefined)
-                        {
-                            alignedNeedle += this->_needleSequence[currentI - 1];
-                            alignedHaystack += "-";
-                        }
-                    }
-
-                    this->_nodes[currentI][currentJ]._value = 0;
-                    this->_nodes[currentI][currentJ]._alreadyMatched = true;
-
-                    currentI = currentNode._tracebackI;
-                    currentJ = currentNode._tracebackJ;
-
-                    currentNode = this->_nodes[currentNode._tracebackI][currentNode._tracebackJ];
-                }
-
-                alignedNeedle.reverse ();
-                alignedHaystack.reverse ();
+                requested *= 2;
+            }
 
-                Match<Tp> match (alignedNeedle, alignedHaystack, score,
-                    currentI + 1, endNeedle, currentJ + 1, endHaystack,
-                    this->_parser != nullptr ? this->_parser : nullptr);
-                this->_matches.push_back (match);
+            int hitCount = 0;
+            size_t k = 0;
+            std::vector<SeedHit> none;
+            for (Match<Tp>& match : matches)
+            {
+                std::vector<SeedHit>& matchSeeds = k < seeds.size () ? seeds[k] : none;
+                ++k;
+                if (!reported (match) || hitCount == this->_amount)
+                    continue;
+                match._haystack._start += this->_offset;
+                match._haystack._end += this->_offset;
+                for (SeedHit& seed : matchSeeds)
+                    seed._haystack += this->_offset;
+                this->_emit (match, matchSeeds);
                 hitCount++;
             }
-            return this->_matches;
+
+            const size_t carried = std::min (this->_buffer.size (), 2 * overlap);
+            this->_offset += this->_buffer.size () - carried;
+            this->_reported = std::max (end, this->_reported) - (this->_buffer.size () - carried);
+            this->_buffer.erase (0, this->_buffer.size () - carried);
+            this->_carried = carried;
         }
 
-        private:
-          Tp _needleSequence;
-          Tp _haystackSequence;
-          int _score;
-          int _amount;
-          ScoreMatrix _scoreSet;
-          std::vector<std::vector<Node>> _nodes;
-          std::list<Match<Tp>> _matches;
-          std::string (*_parser)(Item<Tp>&);
+        /**
+         * repeats()
+         *
+         * @brief
+         * Whether the last two matches of a search are the same, a search only finds the
+         * same match again once it ran out of other matches.
+         */
+        static bool
+        repeats (const std::list<Match<Tp>>& matches)
+        {
+            if (matches.size () < 2)
+                return false;
+            const Match<Tp>& last = matches.back ();
+            const Match<Tp>& before = *std::prev (matches.end (), 2);
+            return last._score == before._score
+                && last._haystack._start == before._haystack._start
+                && last._haystack._end == before._haystack._end
+                && last._needle._start == before._needle._start
+                && last._needle._end == before._needle._end;
+        }
+
+        Tp _needleSequence;
+        size_t _chunk;
+        std::function<void (Match<Tp>&, std::vector<SeedHit>&)> _emit;
+        ScoreMatrix _scoreSet;
+        int _amount;
+        MemoryMode _memoryMode;
+        Engine _engine;
+        unsigned _threads;
+        int _minimumScore;
+        int _maxEdits;
+        Strand _strand;
+        Seeding _seeding;
+        std::string _buffer;
+        size_t _offset;
+        size_t _carried;
+        size_t _reported;
+        std::string (*_parser)(Item<Tp>&);
     };
 
-    ScoreMatrix continuityMatrix { 1, 0, 2 }, disparityMatrix { 1, -1, 0 }, standardMatrix { 1, -1, 1 };
+    constexpr ScorePolicy<1, 0, 2> continuityMatrix;
+    constexpr ScorePolicy<1, -1, 0> disparityMatrix;
+    constexpr ScorePolicy<1, -1, 1> standardMatrix;
 }
 
 typedef sqn::SimpleType<unsigned char, sqn::Dna5Specification> Dna5;
 typedef sqn::Sequence<Dna5> Dna5Sequence;
+typedef sqn::PackedSequence<Dna5> Dna5PackedSequence;
+
+static_assert (sizeof (Dna5) == 1, "Dna5 must not carry per element state");
 
 #endif
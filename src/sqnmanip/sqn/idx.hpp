@@ -0,0 +1,483 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "io.hpp"
+
+#ifndef SQN_IDX_HPP
+#define SQN_IDX_HPP
+
+namespace sqn
+{
+    /**
+     * IndexHit
+     *
+     * @brief
+     * An approximate occurrence of a needle in an indexed text, the position starts at zero
+     * and the length counts the characters of the text covered by the alignment.
+     */
+    class IndexHit
+    {
+      public:
+        size_t _position;
+        size_t _length;
+        int _edits;
+    };
+
+    /**
+     * FMIndex
+     *
+     * @brief
+     * FM-index of a DNA text with a sampled suffix array, built once for a reference and
+     * searched with many needles. Needles are searched backwards with a budget of mismatches,
+     * insertions and deletions, so a search costs with the length of the needle and the
+     * edits and not with the length of the text. The index can be saved and is mapped into
+     * memory when loaded, its arrays are read straight from the file in the byte order of
+     * the machine that saved it.
+     */
+    class FMIndex
+    {
+      public:
+        /**
+         * FMIndex()
+         *
+         * @brief
+         * Build the index of a sequence, every base except A, C, G and T is never matched.
+         * @param text The sequence to be indexed.
+         * @param rate Every rate-th text position keeps its suffix array entry.
+         */
+        template <typename Ts>
+            requires (!std::is_convertible_v<const Ts&, const char*>)
+        explicit FMIndex (const Ts& text, uint32_t rate = 32)
+        {
+            std::vector<uint8_t> codes (text.length ());
+            for (size_t j = 0; j < codes.size (); ++j)
+                codes[j] = FMIndex::code ((char)text[j]);
+            this->build (codes, std::max<uint32_t> (rate, 1));
+        }
+
+        /**
+         * FMIndex()
+         *
+         * @brief
+         * Load an index saved before, the file stays mapped while the index lives.
+         * @param fileName The file written by save().
+         */
+        explicit FMIndex (const char* fileName)
+            : _file (new MappedFile (fileName))
+        {
+            const char* data = this->_file->data ();
+            const size_t size = this->_file->size ();
+            if (size < sizeof (Header) || memcmp (data, FMIndex::_magic, sizeof (FMIndex::_magic)) != 0)
+                throw std::runtime_error (std::string ("Not an index file ") + fileName);
+            memcpy (&this->_header, data, sizeof (Header));
+            if (this->_header.version != FMIndex::_version)
+                throw std::runtime_error (std::string ("Unsupported index version in ") + fileName);
+            size_t offset = sizeof (Header);
+            this->_blocks = this->view<Block> (data, size, offset, this->_header.blocks);
+            this->_marks = this->view<uint64_t> (data, size, offset, this->_header.words);
+            this->_markRanks = this->view<uint32_t> (data, size, offset, this->_header.words);
+            this->_samples = this->view<uint32_t> (data, size, offset, this->_header.samples);
+        }
+
+        /**
+         * save()
+         *
+         * @brief
+         * Write the index to a file that can be loaded and mapped later.
+         * @param fileName The file to be written.
+         */
+        void
+        save (const char* fileName) const
+        {
+            std::ofstream file (fileName, std::ios::binary);
+            if (!file)
+                throw std::runtime_error (std::string ("Cannot write ") + fileName);
+            file.write ((const char*)&this->_header, sizeof (Header));
+            this->write (file, this->_blocks, this->_header.blocks);
+            this->write (file, this->_marks, this->_header.words);
+            this->write (file, this->_markRanks, this->_header.words);
+            this->write (file, this->_samples, this->_header.samples);
+            if (!file)
+                throw std::runtime_error (std::string ("Cannot write ") + fileName);
+        }
+
+        /**
+         * length()
+         *
+         * @brief
+         * The length of the indexed text.
+         */
+        size_t
+        length () const
+        {
+            return this->_header.length;
+        }
+
+        /**
+         * count()
+         *
+         * @brief
+         * Count the exact occurrences of a needle.
+         * @param needle The needle to be counted.
+         */
+        size_t
+        count (std::string_view needle) const
+        {
+            uint64_t low = 0;
+            uint64_t high = this->_header.length + 1;
+            for (size_t i = needle.size (); i > 0 && low < high; --i)
+            {
+                uint8_t symbol = FMIndex::code (needle[i - 1]);
+                if (symbol > FMIndex::_bases)
+                    return 0;
+                low = this->step (symbol, low);
+                high = this->step (symbol, high);
+            }
+            return high > low ? high - low : 0;
+        }
+
+        /**
+         * search()
+         *
+         * @brief
+         * Find the occurrences of a needle with at most the given amount of edits, every
+         * position is reported once with its fewest edits. The hits are ordered by their
+         * edits and then by their position.
+         * @param needle The needle to be searched.
+         * @param edits The amount of mismatches, insertions and deletions allowed.
+         */
+        std::vector<IndexHit>
+        search (std::string_view needle, int edits) const
+        {
+            std::vector<uint8_t> codes (needle.size ());
+            for (size_t i = 0; i < codes.size (); ++i)
+                codes[i] = FMIndex::code (needle[i]);
+            std::vector<IndexHit> hits;
+            if (!codes.empty ())
+                this->backtrack (codes, codes.size (), 0, this->_header.length + 1,
+                    std::max (edits, 0), 0, 0, Edit::match, hits);
+
+            std::sort (hits.begin (), hits.end (), [] (const IndexHit& a, const IndexHit& b) {
+                return a._position != b._position ? a._position < b._position
+                    : a._edits != b._edits ? a._edits < b._edits : a._length < b._length;
+            });
+            hits.erase (std::unique (hits.begin (), hits.end (), [] (const IndexHit& a, const IndexHit& b) {
+                return a._position == b._position;
+            }), hits.end ());
+            std::stable_sort (hits.begin (), hits.end (), [] (const IndexHit& a, const IndexHit& b) {
+                return a._edits < b._edits;
+            });
+            return hits;
+        }
+        template <typename Ts>
+            requires (!std::is_convertible_v<const Ts&, const char*>)
+        std::vector<IndexHit>
+        search (const Ts& needle, int edits) const
+        {
+            std::string characters (needle.length (), '\0');
+            for (size_t i = 0; i < characters.size (); ++i)
+                characters[i] = (char)needle[i];
+            return this->search (std::string_view (characters), edits);
+        }
+
+      private:
+        /* Symbols are ranked as $ < A < C < G < T < N, only A to N are kept in the blocks */
+        static constexpr uint8_t _bases = 4;
+        static constexpr uint8_t _symbols = 5;
+        static constexpr char _magic[8] = { 'S', 'Q', 'N', 'F', 'M', 'I', 'D', 'X' };
+        static constexpr uint32_t _version = 1;
+
+        enum class Edit { match, insertion, deletion };
+
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t rate;
+            uint64_t length;
+            uint64_t before[FMIndex::_symbols + 2];
+            uint64_t blocks;
+            uint64_t words;
+            uint64_t samples;
+        };
+
+        /* Ranks of 64 rows of the Burrows-Wheeler transform, one cache line each */
+        struct Block
+        {
+            uint32_t counts[FMIndex::_symbols];
+            uint32_t padding;
+            uint64_t masks[FMIndex::_symbols];
+        };
+
+        static uint8_t
+        code (char value)
+        {
+            switch (value | 0x20)
+            {
+                case 'a': return 1;
+                case 'c': return 2;
+                case 'g': return 3;
+                case 't': return 4;
+                default: return FMIndex::_symbols;
+            }
+        }
+
+        /**
+         * build()
+         *
+         * @brief
+         * Sort the suffixes by prefix doubling with counting sorts, then keep the ranks of
+         * the Burrows-Wheeler transform in blocks and the sampled suffix array entries.
+         */
+        void
+        build (const std::vector<uint8_t>& text, uint32_t rate)
+        {
+            const size_t rows = text.size () + 1;
+            if (rows > UINT32_MAX)
+                throw std::invalid_argument ("Texts of an index are limited to 4 Gbp");
+            std::vector<uint32_t> suffixes (rows), ranks (rows), next (rows);
+            std::vector<uint32_t> buckets (std::max<size_t> (rows, FMIndex::_symbols + 1) + 1);
+            for (size_t i = 0; i < rows; ++i)
+                ranks[i] = i < text.size () ? text[i] : 0;
+
+            auto sort = [&] (const std::vector<uint32_t>& order, size_t symbols) {
+                std::fill (buckets.begin (), buckets.begin () + symbols + 1, 0);
+                for (size_t i = 0; i < rows; ++i)
+                    ++buckets[ranks[order[i]] + 1];
+                for (size_t s = 1; s <= symbols; ++s)
+                    buckets[s] += buckets[s - 1];
+                for (size_t i = 0; i < rows; ++i)
+                    suffixes[buckets[ranks[order[i]]]++] = order[i];
+            };
+            for (size_t i = 0; i < rows; ++i)
+                next[i] = i;
+            sort (next, FMIndex::_symbols + 1);
+
+            size_t classes = FMIndex::_symbols + 1;
+            for (size_t k = 1;; k <<= 1)
+            {
+                /* Order by the rank k positions ahead first, suffixes shorter than that
+                 * come first, then stably by their own rank */
+                size_t filled = 0;
+                for (size_t i = rows - std::min (k, rows); i < rows; ++i)
+                    next[filled++] = i;
+                for (size_t i = 0; i < rows; ++i)
+                    if (suffixes[i] >= k)
+                        next[filled++] = suffixes[i] - k;
+                sort (next, classes);
+
+                next[suffixes[0]] = 0;
+                classes = 1;
+                for (size_t i = 1; i < rows; ++i)
+                {
+                    uint32_t a = suffixes[i - 1];
+                    uint32_t b = suffixes[i];
+                    bool same = ranks[a] == ranks[b] && a + k < rows && b + k < rows
+                        && ranks[a + k] == ranks[b + k];
+                    classes += !same;
+                    next[b] = classes - 1;
+                }
+                std::swap (ranks, next);
+                if (classes == rows)
+                    break;
+            }
+
+            this->_header = {};
+            memcpy (this->_header.magic, FMIndex::_magic, sizeof (FMIndex::_magic));
+            this->_header.version = FMIndex::_version;
+            this->_header.rate = rate;
+            this->_header.length = text.size ();
+            this->_header.blocks = rows / 64 + 1;
+            this->_header.words = rows / 64 + 1;
+
+            std::vector<uint64_t> before (FMIndex::_symbols + 2, 0);
+            for (uint8_t symbol : text)
+                ++before[symbol + 1];
+            before[1] += 1;
+            for (size_t s = 1; s < before.size (); ++s)
+                before[s] += before[s - 1];
+            std::copy (before.begin (), before.end (), this->_header.before);
+
+            this->_ownedBlocks.assign (this->_header.blocks, Block {});
+            this->_ownedMarks.assign (this->_header.words, 0);
+            this->_ownedMarkRanks.assign (this->_header.words, 0);
+            uint32_t counts[FMIndex::_symbols] = {};
+            for (size_t i = 0; i < rows; ++i)
+            {
+                Block& block = this->_ownedBlocks[i / 64];
+                if (i % 64 == 0)
+                    std::copy (counts, counts + FMIndex::_symbols, block.counts);
+                if (suffixes[i] > 0)
+                {
+                    uint8_t symbol = text[suffixes[i] - 1];
+                    block.masks[symbol - 1] |= (uint64_t)1 << (i % 64);
+                    ++counts[symbol - 1];
+                }
+                if (suffixes[i] % rate == 0)
+                {
+                    this->_ownedMarks[i / 64] |= (uint64_t)1 << (i % 64);
+                    this->_ownedSamples.push_back (suffixes[i]);
+                }
+            }
+            if (rows % 64 == 0)
+                std::copy (counts, counts + FMIndex::_symbols, this->_ownedBlocks.back ().counts);
+            for (size_t w = 1; w < this->_ownedMarkRanks.size (); ++w)
+                this->_ownedMarkRanks[w] = this->_ownedMarkRanks[w - 1]
+                    + std::popcount (this->_ownedMarks[w - 1]);
+            this->_header.samples = this->_ownedSamples.size ();
+
+            this->_blocks = this->_ownedBlocks.data ();
+            this->_marks = this->_ownedMarks.data ();
+            this->_markRanks = this->_ownedMarkRanks.data ();
+            this->_samples = this->_ownedSamples.data ();
+        }
+
+        /**
+         * occurrences(), step()
+         *
+         * @brief
+         * The occurrences of a symbol in the rows before a row, and the row a suffix starting
+         * with the symbol in front of that row is sorted to.
+         */
+        uint64_t
+        occurrences (uint8_t symbol, uint64_t row) const
+        {
+            const Block& block = this->_blocks[row / 64];
+            uint64_t below = ((uint64_t)1 << (row % 64)) - 1;
+            return block.counts[symbol - 1] + std::popcount (block.masks[symbol - 1] & below);
+        }
+        uint64_t
+        step (uint8_t symbol, uint64_t row) const
+        {
+            return this->_header.before[symbol] + this->occurrences (symbol, row);
+        }
+
+        /**
+         * locate()
+         *
+         * @brief
+         * The text position of a row, rows are stepped back until a sampled one is reached.
+         * The first text position is always sampled, so the row of the whole text is never
+         * stepped past.
+         */
+        size_t
+        locate (uint64_t row) const
+        {
+            size_t steps = 0;
+            while (!((this->_marks[row / 64] >> (row % 64)) & 1))
+            {
+                const Block& block = this->_blocks[row / 64];
+                uint8_t symbol = 1;
+                while (!((block.masks[symbol - 1] >> (row % 64)) & 1))
+                    ++symbol;
+                row = this->step (symbol, row);
+                ++steps;
+            }
+            uint64_t below = ((uint64_t)1 << (row % 64)) - 1;
+            size_t sample = this->_markRanks[row / 64] + std::popcount (this->_marks[row / 64] & below);
+            return this->_samples[sample] + steps;
+        }
+
+        /**
+         * backtrack()
+         *
+         * @brief
+         * Extend the rows of a needle suffix by one more needle character, by a mismatching
+         * base, by a base missing from the needle or by skipping a needle character, each
+         * edit is paid from the budget. A skipped needle character next to a base missing
+         * from the needle costs more than a mismatch and is never tried, so an alignment
+         * never starts with a base missing from the needle.
+         * @param needle The needle codes.
+         * @param i The needle characters still to be matched.
+         * @param low, high The rows of the text suffixes aligned so far.
+         * @param budget, used The edits left and spent.
+         * @param length The text characters aligned so far.
+         * @param previous The edit that extended the alignment last.
+         * @param hits Receives the occurrences.
+         */
+        void
+        backtrack (const std::vector<uint8_t>& needle, size_t i, uint64_t low, uint64_t high,
+                   int budget, int used, size_t length, Edit previous,
+                   std::vector<IndexHit>& hits) const
+        {
+            if (i == 0)
+            {
+                if (length == 0)
+                    return;
+                for (uint64_t row = low; row < high; ++row)
+                    hits.push_back ({ this->locate (row), length, used });
+                return;
+            }
+            if (budget > 0 && previous != Edit::deletion)
+                this->backtrack (needle, i - 1, low, high, budget - 1, used + 1, length,
+                    Edit::insertion, hits);
+            for (uint8_t symbol = 1; symbol <= FMIndex::_symbols; ++symbol)
+            {
+                uint64_t nextLow = this->step (symbol, low);
+                uint64_t nextHigh = this->step (symbol, high);
+                if (nextLow >= nextHigh)
+                    continue;
+                if (symbol == needle[i - 1] && symbol <= FMIndex::_bases)
+                    this->backtrack (needle, i - 1, nextLow, nextHigh, budget, used, length + 1,
+                        Edit::match, hits);
+                else if (budget > 0)
+                    this->backtrack (needle, i - 1, nextLow, nextHigh, budget - 1, used + 1,
+                        length + 1, Edit::match, hits);
+
+                /* A text base in front of the aligned part, never at the end of the needle */
+                if (budget > 0 && i < needle.size () && previous != Edit::insertion)
+                    this->backtrack (needle, i, nextLow, nextHigh, budget - 1, used + 1,
+                        length + 1, Edit::deletion, hits);
+            }
+        }
+
+        /**
+         * view(), write()
+         *
+         * @brief
+         * Point an array into the mapped file and write an array padded to eight bytes.
+         */
+        template <typename T>
+        static const T*
+        view (const char* data, size_t size, size_t& offset, uint64_t count)
+        {
+            size_t bytes = count * sizeof (T);
+            if (offset + bytes > size)
+                throw std::runtime_error ("Truncated index file");
+            const T* result = reinterpret_cast<const T*> (data + offset);
+            offset += (bytes + 7) & ~(size_t)7;
+            return result;
+        }
+        template <typename T>
+        static void
+        write (std::ofstream& file, const T* array, uint64_t count)
+        {
+            static const char padding[8] = {};
+            size_t bytes = count * sizeof (T);
+            file.write ((const char*)array, bytes);
+            file.write (padding, ((bytes + 7) & ~(size_t)7) - bytes);
+        }
+
+        Header _header;
+        const Block* _blocks;
+        const uint64_t* _marks;
+        const uint32_t* _markRanks;
+        const uint32_t* _samples;
+        std::vector<Block> _ownedBlocks;
+        std::vector<uint64_t> _ownedMarks;
+        std::vector<uint32_t> _ownedMarkRanks;
+        std::vector<uint32_t> _ownedSamples;
+        std::unique_ptr<MappedFile> _file;
+    };
+}
+
+#endif
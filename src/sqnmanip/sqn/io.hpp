@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined (__unix__) || defined (__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined (SQN_ZLIB)
+#include <zlib.h>
+#endif
+
+#ifndef SQN_IO_HPP
+#define SQN_IO_HPP
+
+namespace sqn
+{
+    /**
+     * MappedFile
+     *
+     * @brief
+     * Read-only contents of a file, mapped into memory where the platform supports it and
+     * read into a buffer otherwise. Gzip compressed files are inflated into a buffer when
+     * the library is built with SQN_ZLIB.
+     */
+    class MappedFile
+    {
+      public:
+        MappedFile (const char* fileName)
+            : _data (nullptr), _size (0), _mapped (false)
+        {
+#if defined (__unix__) || defined (__APPLE__)
+            int descriptor = open (fileName, O_RDONLY);
+            if (descriptor < 0)
+                throw std::runtime_error (std::string ("Cannot open ") + fileName);
+            struct stat status;
+            if (fstat (descriptor, &status) == 0 && status.st_size > 0)
+            {
+                void* data = mmap (nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (data != MAP_FAILED)
+                {
+                    madvise (data, status.st_size, MADV_SEQUENTIAL);
+                    this->_data = static_cast<const char*> (data);
+                    this->_size = status.st_size;
+                    this->_mapped = true;
+                }
+            }
+            close (descriptor);
+#endif
+            if (!this->_mapped)
+            {
+                std::ifstream file (fileName, std::ios::binary);
+                if (!file)
+                    throw std::runtime_error (std::string ("Cannot open ") + fileName);
+                this->_buffer.assign (std::istreambuf_iterator<char> (file),
+                    std::istreambuf_iterator<char> ());
+                this->_data = this->_buffer.data ();
+                this->_size = this->_buffer.size ();
+            }
+
+            if (this->_size >= 2 && (unsigned char)this->_data[0] == 0x1f
+                && (unsigned char)this->_data[1] == 0x8b)
+                this->inflate (fileName);
+        }
+        MappedFile (const MappedFile&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+        ~MappedFile ()
+        {
+            this->unmap ();
+        }
+
+        const char*
+        data () const
+        {
+            return this->_data;
+        }
+        size_t
+        size () const
+        {
+            return this->_size;
+        }
+
+      private:
+        void
+        unmap ()
+        {
+#if defined (__unix__) || defined (__APPLE__)
+            if (this->_mapped)
+                munmap (const_cast<char*> (this->_data), this->_size);
+#endif
+            this->_mapped = false;
+        }
+
+        /**
+         * inflate()
+         *
+         * @brief
+         * Replace the compressed contents with the inflated ones, chunk by chunk so that
+         * concatenated gzip members are read as well.
+         */
+        void
+        inflate (const char* fileName)
+        {
+#if defined (SQN_ZLIB)
+            std::string output;
+            z_stream stream {};
+            if (inflateInit2 (&stream, 16 + MAX_WBITS) != Z_OK)
+                throw std::runtime_error (std::string ("Cannot inflate ") + fileName);
+            stream.next_in = (Bytef*)this->_data;
+            stream.avail_in = (uInt)this->_size;
+            char chunk[1 << 16];
+            int status = Z_OK;
+            while (status != Z_STREAM_END || stream.avail_in > 0)
+            {
+                if (status == Z_STREAM_END)
+                    inflateReset (&stream);
+                stream.next_out = (Bytef*)chunk;
+                stream.avail_out = sizeof (chunk);
+                status = ::inflate (&stream, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END)
+                {
+                    inflateEnd (&stream);
+                    throw std::runtime_error (std::string ("Corrupt gzip data in ") + fileName);
+                }
+                output.append (chunk, sizeof (chunk) - stream.avail_out);
+            }
+            inflateEnd (&stream);
+            this->unmap ();
+            this->_buffer.swap (output);
+            this->_data = this->_buffer.data ();
+            this->_size = this->_buffer.size ();
+#else
+            throw std::runtime_error (std::string ("Reading gzip compressed ") + fileName
+                + " needs SQN_ZLIB");
+#endif
+        }
+
+        const char* _data;
+        size_t _size;
+        bool _mapped;
+        std::string _buffer;
+    };
+
+    /**
+     * Record
+     *
+     * @brief
+     * One record of a FASTA or FASTQ file, the bases and qualities refer to the file
+     * contents and may still contain line breaks.
+     */
+    class Record
+    {
+      public:
+        std::string_view _name;
+        std::string_view _bases;
+        std::string_view _qualities;
+
+        /**
+         * read()
+         *
+         * @brief
+         * Append the bases without line breaks to a sequence in one pass, line breaks are
+         * found with memchr and the lines are gathered in a small buffer so that the
+         * sequence receives long runs it can encode in bulk.
+         * @param sequence The sequence that receives the bases.
+         */
+        template <typename Ts>
+        void
+        read (Ts& sequence) const
+        {
+            char buffer[1 << 16];
+            size_t used = 0;
+            const char* first = this->_bases.data ();
+            const char* last = first + this->_bases.size ();
+            while (first < last)
+            {
+                const char* end = static_cast<const char*> (memchr (first, '\n', last - first));
+                if (end == nullptr)
+                    end = last;
+                const char* lineEnd = end > first && end[-1] == '\r' ? end - 1 : end;
+                for (size_t length = lineEnd - first; length > 0;)
+                {
+                    size_t count = std::min (length, sizeof (buffer) - used);
+                    memcpy (buffer + used, first, count);
+                    used += count;
+                    first += count;
+                    length -= count;
+                    if (used == sizeof (buffer))
+                    {
+                        sequence.append (buffer, used);
+                        used = 0;
+                    }
+                }
+                first = end + 1;
+            }
+            if (used > 0)
+                sequence.append (buffer, used);
+        }
+
+        /**
+         * bases(), qualities()
+         *
+         * @brief
+         * Copy the bases or qualities without line breaks.
+         */
+        std::string
+        bases () const
+        {
+            std::string result;
+            result.reserve (this->_bases.size ());
+            this->read (result);
+            return result;
+        }
+        std::string
+        qualities () const
+        {
+            Record qualities = { this->_name, this->_qualities, {} };
+            return qualities.bases ();
+        }
+    };
+
+    /**
+     * SequenceReader
+     *
+     * @brief
+     * Read the records of a FASTA or FASTQ file one after another, the format of a record
+     * is taken from its first character.
+     */
+    class SequenceReader
+    {
+      public:
+        SequenceReader (const char* fileName)
+            : _file (fileName), _position (0) {}
+
+        /**
+         * next()
+         *
+         * @brief
+         * Read the next record.
+         * @param record Receives the record.
+         * @return Whether a record was read.
+         */
+        bool
+        next (Record& record)
+        {
+            const char* data = this->_file.data ();
+            const size_t size = this->_file.size ();
+            while (this->_position < size && (data[this->_position] == '\n'
+                || data[this->_position] == '\r'))
+                ++this->_position;
+            if (this->_position >= size)
+                return false;
+
+            char marker = data[this->_position];
+            if (marker != '>' && marker != '@')
+                throw std::runtime_error ("Records have to start with '>' or '@'");
+
+            size_t nameEnd = this->lineEnd (this->_position);
+            record._name = this->view (this->_position + 1, nameEnd);
+            this->_position = this->nextLine (nameEnd);
+            record._qualities = {};
+
+            if (marker == '>')
+            {
+                size_t basesEnd = this->_position;
+                while (basesEnd < size)
+                {
+                    const char* found = static_cast<const char*> (
+                        memchr (data + basesEnd, '>', size - basesEnd));
+                    if (found == nullptr)
+                    {
+                        basesEnd = size;
+                        break;
+                    }
+                    basesEnd = found - data;
+                    if (basesEnd == 0 || data[basesEnd - 1] == '\n')
+                        break;
+                    ++basesEnd;
+                }
+                record._bases = this->view (this->_position, basesEnd);
+                this->_position = basesEnd;
+                return true;
+            }
+
+            /* FASTQ bases may span lines until the separator, the qualities span
+             * as many characters as there are bases */
+            size_t basesBegin = this->_position;
+            size_t bases = 0;
+            while (this->_position < size && data[this->_position] != '+')
+            {
+                size_t end = this->lineEnd (this->_position);
+                bases += end - this->_position;
+                this->_position = this->nextLine (end);
+            }
+            record._bases = this->view (basesBegin, this->_position);
+            if (this->_position >= size)
+                throw std::runtime_error ("FASTQ record without qualities");
+            this->_position = this->nextLine (this->lineEnd (this->_position));
+
+            size_t qualitiesBegin = this->_position;
+            size_t qualities = 0;
+            while (this->_position < size && qualities < bases)
+            {
+                size_t end = this->lineEnd (this->_position);
+                qualities += end - this->_position;
+                this->_position = this->nextLine (end);
+            }
+            if (qualities != bases)
+                throw std::runtime_error ("FASTQ qualities do not match the bases");
+            record._qualities = this->view (qualitiesBegin, this->_position);
+            return true;
+        }
+
+      private:
+        /**
+         * lineEnd(), nextLine()
+         *
+         * @brief
+         * The end of the line at a position without line break and the begin of the next line.
+         */
+        size_t
+        lineEnd (size_t position) const
+        {
+            const char* data = this->_file.data ();
+            const char* found = static_cast<const char*> (
+                memchr (data + position, '\n', this->_file.size () - position));
+            size_t end = found != nullptr ? found - data : this->_file.size ();
+            return end > position && data[end - 1] == '\r' ? end - 1 : end;
+        }
+        size_t
+        nextLine (size_t end) const
+        {
+            const char* data = this->_file.data ();
+            while (end < this->_file.size () && data[end] == '\r')
+                ++end;
+            return end < this->_file.size () ? end + 1 : end;
+        }
+        std::string_view
+        view (size_t begin, size_t end) const
+        {
+            return std::string_view (this->_file.data () + begin, end - begin);
+        }
+
+        MappedFile _file;
+        size_t _position;
+    };
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <list>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sqnmanip/sqn/fzy.hpp>
+
+/**
+ * randomBases
+ *
+ * @brief
+ * Synthetic bases drawn uniformly from a, c, g and t.
+ */
+std::string randomBases (size_t length, std::mt19937& random) {
+    std::string bases(length, 'a');
+    for (char& base : bases)
+        base = "acgt"[random() % 4];
+    return bases;
+}
+
+/**
+ * describe
+ *
+ * @brief
+ * The positions and scores of a list of matches.
+ */
+std::string describe (std::list<sqn::Match<Dna5Sequence>>& matches) {
+    std::ostringstream out;
+    for (sqn::Match<Dna5Sequence>& match : matches)
+        out << match.needle() << "\n" << match.haystack() << "\n" << match.score() << "\n";
+    return out.str();
+}
+std::string describe (std::vector<std::vector<sqn::SeedHit>>& seeds) {
+    std::ostringstream out;
+    for (std::vector<sqn::SeedHit>& match : seeds) {
+        for (sqn::SeedHit& seed : match)
+            out << seed._needle << ":" << seed._haystack << " ";
+        out << "\n";
+    }
+    return out.str();
+}
+
+/* A seeded batch query reports the same matches and seeds as a seeded query per needle, the
+ * matches differ from those of an unseeded one since only windows around seed hits are aligned */
+int main () {
+    std::mt19937 random(11);
+    const sqn::Seeding seeding("1111011110111", 2, 16);
+    std::string haystack = randomBases(20000, random);
+    std::vector<Dna5Sequence> needles;
+    for (int k = 0; k < 8; ++k) {
+        std::string needle = randomBases(40, random);
+        haystack.replace(1000 + k * 2300, needle.size(), needle);
+        needles.emplace_back(needle);
+    }
+
+    sqn::FuzzyBatchQuery<Dna5Sequence> batch = {Dna5Sequence(haystack), needles};
+    batch.initializeScoreMatrix(sqn::standardMatrix, 3);
+    batch.setSeeding(seeding);
+    batch.setThreads(3);
+    std::vector<std::list<sqn::Match<Dna5Sequence>>>& found = batch.search();
+
+    int failures = 0;
+    bool seededOnly = false;
+    for (size_t k = 0; k < needles.size(); ++k) {
+        sqn::FuzzyQuery<Dna5Sequence> seeded = {Dna5Sequence(haystack), needles[k]};
+        seeded.initializeScoreMatrix(sqn::standardMatrix, 3);
+        seeded.setSeeding(seeding);
+        sqn::FuzzyQuery<Dna5Sequence> unseeded = {Dna5Sequence(haystack), needles[k]};
+        unseeded.initializeScoreMatrix(sqn::standardMatrix, 3);
+
+        std::string expected = describe(seeded.search());
+        expected += describe(seeded.seeds());
+        std::string actual = describe(found[k]) + describe(batch.seeds()[k]);
+        if (expected != actual) {
+            std::cerr << "needle " << k << ": seeded batch query differs\n"
+                << expected << "--\n" << actual << std::endl;
+            ++failures;
+        }
+        seededOnly |= describe(found[k]) != describe(unseeded.search());
+    }
+    if (!seededOnly || batch.seeds()[0].empty()) {
+        std::cerr << "the batch query was not seeded" << std::endl;
+        ++failures;
+    }
+    return failures > 0;
+}
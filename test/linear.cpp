@@ -0,0 +1,80 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <sqnmanip/sqn/fzy.hpp>
+
+/**
+ * randomBases
+ *
+ * @brief
+ * Synthetic bases drawn uniformly from a, c, g and t.
+ */
+std::string randomBases (size_t length, std::mt19937& random) {
+    std::string bases(length, 'a');
+    for (char& base : bases)
+        base = "acgt"[random() % 4];
+    return bases;
+}
+
+/**
+ * noisyCopy
+ *
+ * @brief
+ * A copy of the bases with about one in twenty substituted, deleted or followed by an
+ * inserted base.
+ */
+std::string noisyCopy (const std::string& bases, std::mt19937& random) {
+    std::string copy;
+    for (char base : bases) {
+        switch (random() % 60) {
+            case 0: copy += "acgt"[random() % 4]; break;
+            case 1: break;
+            case 2: copy += base; copy += "acgt"[random() % 4]; break;
+            default: copy += base;
+        }
+    }
+    return copy;
+}
+
+/**
+ * matches
+ *
+ * @brief
+ * The positions, scores and edit scripts of the matches of a query in one memory mode.
+ */
+std::string matches (const std::string& haystack, const std::string& needle,
+                     const sqn::ScoreMatrix& scores, sqn::MemoryMode mode) {
+    sqn::FuzzyQuery<Dna5Sequence> query = {Dna5Sequence(haystack), Dna5Sequence(needle)};
+    query.initializeScoreMatrix(scores, 3);
+    query.setMemoryMode(mode);
+    std::ostringstream out;
+    for (sqn::Match<Dna5Sequence>& match : query.search())
+        out << match.needle() << "\n" << match.haystack() << "\n" << match.score() << " "
+            << match.cigar() << "\n";
+    return out.str();
+}
+
+/* Matches long enough that the linear memory mode rebuilds their traces in several sweeps
+ * have to be the same as those of the matrix mode */
+int main () {
+    int failures = 0;
+    const sqn::ScoreMatrix matrices[] = {sqn::standardMatrix, sqn::disparityMatrix};
+    for (unsigned seed = 1; seed <= 6; ++seed) {
+        std::mt19937 random(seed);
+        std::string needle = randomBases(1100, random);
+        std::string haystack = randomBases(300, random) + noisyCopy(needle, random)
+            + randomBases(200, random) + noisyCopy(needle, random) + randomBases(300, random);
+        for (const sqn::ScoreMatrix& scores : matrices) {
+            std::string matrix = matches(haystack, needle, scores, sqn::MemoryMode::matrix);
+            std::string linear = matches(haystack, needle, scores, sqn::MemoryMode::linear);
+            if (matrix != linear) {
+                std::cerr << "seed " << seed << ": linear memory mode differs\n"
+                    << matrix << "--\n" << linear << std::endl;
+                ++failures;
+            }
+        }
+    }
+    return failures > 0;
+}
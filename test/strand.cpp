@@ -0,0 +1,31 @@
+#include <iostream>
+#include <list>
+
+#include <sqnmanip/sqn/fzy.hpp>
+
+/* The EagI site is its own reverse complement, searching both strands reports it once, and a
+ * match on the reverse strand shows the needle reverse complemented */
+int main () {
+    sqn::FuzzyQuery<Dna5Sequence> query = {Dna5Sequence("ttttttcggccgtttttt"), Dna5Sequence("CGGCCG")};
+    query.initializeScoreMatrix(sqn::standardMatrix, 3);
+    query.setStrand(sqn::Strand::both);
+    std::list<sqn::Match<Dna5Sequence>>& matches = query.search();
+
+    int sites = 0;
+    for (sqn::Match<Dna5Sequence>& match : matches)
+        sites += match.haystack() == "CGGCCG from 7 to 12";
+    if (sites != 1) {
+        std::cerr << "the site was reported " << sites << " times" << std::endl;
+        return 1;
+    }
+
+    sqn::FuzzyQuery<Dna5Sequence> reverse = {Dna5Sequence("ttttttacggttgttttt"), Dna5Sequence("AACCGT")};
+    reverse.initializeScoreMatrix(sqn::standardMatrix, 1);
+    reverse.setStrand(sqn::Strand::both);
+    sqn::Match<Dna5Sequence>& best = reverse.search().front();
+    if (best._strand != sqn::Strand::reverse || best.needle() != "ACGGTT from 1 to 6") {
+        std::cerr << "the reverse match shows " << best.needle() << std::endl;
+        return 1;
+    }
+    return 0;
+}
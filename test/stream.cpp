@@ -0,0 +1,32 @@
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <sqnmanip/sqn/fzy.hpp>
+
+/* A match across the boundary of two chunks is reported once and whole, by the chunk that
+ * finds all of it */
+int main () {
+    std::mt19937 random(3);
+    std::string haystack(300, 'a');
+    for (char& base : haystack)
+        base = "acgt"[random() % 4];
+    haystack.replace(94, 14, "gattacagattaca");
+
+    int whole = 0;
+    int cut = 0;
+    sqn::FuzzyStreamQuery<Dna5Sequence> stream = {Dna5Sequence("gattacagattaca"), /*chunk*/100,
+        [&](sqn::Match<Dna5Sequence>& match) {
+            whole += match.haystack() == "GATTACAGATTACA from 95 to 108";
+            cut += match.haystack() == "GATTAC from 95 to 100";
+        }};
+    stream.initializeScoreMatrix(sqn::standardMatrix, 3);
+    stream.append(haystack.data(), haystack.size());
+    stream.finish();
+    if (whole != 1 || cut != 0) {
+        std::cerr << "the match across the boundary was reported " << whole << " times whole and "
+            << cut << " times cut" << std::endl;
+        return 1;
+    }
+    return 0;
+}